@@ -0,0 +1,61 @@
+#include "benchmark_cache.hpp"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <algorithm>
+#include "database.hpp"
+#include "fund_series.hpp"
+
+auto BenchmarkSeries::find(const int& month) const -> int {
+  const auto it = std::lower_bound(months.begin(), months.end(), month);
+
+  if (it == months.end() || *it != month) {
+    return -1;
+  }
+
+  return static_cast<int>(it - months.begin());
+}
+
+void BenchmarkCache::set_database(const QSqlDatabase& database) {
+  db = database;
+
+  clear();
+}
+
+auto BenchmarkCache::get(const QString& table_name) -> BenchmarkSeries {
+  auto it = cache.find(table_name);
+
+  if (it == cache.end()) {
+    it = cache.insert(table_name, load(table_name));
+  }
+
+  return it.value();
+}
+
+void BenchmarkCache::clear() {
+  cache.clear();
+
+  revision_count++;
+}
+
+auto BenchmarkCache::load(const QString& table_name) const -> BenchmarkSeries {
+  BenchmarkSeries series;
+
+  auto& query = cached_query(db, "select distinct date,value from " + table_name + " order by date");
+
+  if (query.exec()) {
+    while (query.next()) {
+      const int date = query.value(0).toInt();
+
+      series.dates.append(date);
+      series.months.append(month_key(date));
+      series.values.append(query.value(1).toDouble());
+    }
+
+    query.finish();
+  } else {
+    qDebug() << "Failed to get " + table_name.toUtf8() + " table values: " + query.lastError().text().toUtf8();
+  }
+
+  return series;
+}
@@ -0,0 +1,50 @@
+#ifndef BENCHMARK_CACHE_HPP
+#define BENCHMARK_CACHE_HPP
+
+#include <QHash>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+
+// Monthly values of a benchmark table sorted by date
+
+struct BenchmarkSeries {
+  QVector<int> months;  // see month_key()
+  QVector<int> dates;
+  QVector<double> values;
+
+  [[nodiscard]] auto size() const -> int { return months.size(); }
+
+  // index of the row with the given month key or -1 if the month is not in the series
+
+  [[nodiscard]] auto find(const int& month) const -> int;
+};
+
+/*
+  Benchmark tables are read from the database only once and then shared by the fund and portfolio calculations. The
+  cache has to be cleared whenever a benchmark table is saved, renamed or removed.
+*/
+
+class BenchmarkCache {
+ public:
+  void set_database(const QSqlDatabase& database);
+
+  auto get(const QString& table_name) -> BenchmarkSeries;
+
+  void clear();
+
+  // incremented every time the cache is cleared. Lets the tables know if a calculation used outdated benchmarks
+
+  [[nodiscard]] auto revision() const -> int { return revision_count; }
+
+ private:
+  int revision_count = 0;
+
+  QSqlDatabase db;
+
+  QHash<QString, BenchmarkSeries> cache;
+
+  [[nodiscard]] auto load(const QString& table_name) const -> BenchmarkSeries;
+};
+
+#endif
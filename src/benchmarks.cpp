@@ -0,0 +1,308 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <random>
+#include "calculations.hpp"
+#include "math.hpp"
+#include "projection.hpp"
+#include "series_alignment.hpp"
+
+/*
+  Times the calculation kernels on synthetic investments and writes the results as json. The investments do not
+  start all in the same month so the portfolio and the alignment code have to deal with missing months like they do
+  with real data.
+*/
+
+namespace {
+
+struct Synthetic {
+  QVector<FundSeries> funds;
+
+  BenchmarkSeries inflation;
+};
+
+auto make_synthetic(const int& n_funds, const int& n_months, const unsigned int& seed) -> Synthetic {
+  std::mt19937_64 rng(seed);
+
+  std::normal_distribution<double> monthly_return(0.6, 1.5);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> late_start(0, n_months / 4);
+
+  const int first_month = 2000 * 12;
+
+  Synthetic data;
+
+  for (int m = 0; m < n_months; m++) {
+    data.inflation.months.append(first_month + m);
+    data.inflation.dates.append(month_key_to_epoch(first_month + m));
+    data.inflation.values.append(0.4 + 0.2 * uniform(rng));
+  }
+
+  data.funds.resize(n_funds);
+
+  for (auto& fund : data.funds) {
+    const int start = late_start(rng);
+
+    fund.resize(n_months - start);
+
+    double balance = 1000.0 + 9000.0 * uniform(rng);
+
+    for (int n = 0; n < fund.size(); n++) {
+      fund.months[n] = first_month + start + n;
+      fund.dates[n] = month_key_to_epoch(fund.months[n]);
+
+      fund.deposit[n] = (n == 0 || uniform(rng) < 0.3) ? 100.0 + 900.0 * uniform(rng) : 0.0;
+      fund.withdrawal[n] = (uniform(rng) < 0.05) ? 0.1 * balance * uniform(rng) : 0.0;
+
+      fund.starting_balance[n] = balance;
+
+      balance = (balance + fund.deposit[n] - fund.withdrawal[n]) * (1.0 + 0.01 * monthly_return(rng));
+
+      fund.ending_balance[n] = balance;
+    }
+  }
+
+  return data;
+}
+
+// Same steps used by FundPCA::process_tables. Returns the explained variance of the first component
+
+auto pca_explained_variance(const QVector<FundSeries const*>& funds, const int& n_months) -> double {
+  const auto aligned = align_series(funds, &FundSeries::net_return_perc, n_months);
+
+  return principal_components(aligned.values, aligned.mask, 2).explained_variance(0);
+}
+
+// Runs the kernel "repetitions" times and returns the minimum, median and mean run times in microseconds
+
+auto measure(const QString& name, const int& repetitions, const std::function<void()>& kernel) -> QJsonObject {
+  QVector<double> times;
+
+  QElapsedTimer timer;
+
+  kernel();  // warm up
+
+  for (int n = 0; n < repetitions; n++) {
+    timer.start();
+
+    kernel();
+
+    times.append(timer.nsecsElapsed() * 0.001);
+  }
+
+  std::sort(times.begin(), times.end());
+
+  QJsonObject output;
+
+  output["name"] = name;
+  output["min_us"] = times.first();
+  output["median_us"] = times[times.size() / 2];
+  output["mean_us"] = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+
+  return output;
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+
+  parser.setApplicationDescription("Times the calculation kernels on synthetic investments");
+  parser.addHelpOption();
+
+  QCommandLineOption funds_option({"f", "funds"}, "Number of investments.", "count", "50");
+  QCommandLineOption months_option({"m", "months"}, "Number of months of the longest investment.", "count", "240");
+  QCommandLineOption pca_option({"p", "pca-months"}, "Time window used in the principal component analysis.", "count",
+                                "120");
+  QCommandLineOption repetitions_option({"r", "repetitions"}, "Number of times each kernel is run.", "count", "20");
+  QCommandLineOption seed_option({"s", "seed"}, "Seed of the random number generator.", "seed", "1");
+  QCommandLineOption output_option({"o", "output"}, "Json file where the results are written.", "file");
+
+  parser.addOption(funds_option);
+  parser.addOption(months_option);
+  parser.addOption(pca_option);
+  parser.addOption(repetitions_option);
+  parser.addOption(seed_option);
+  parser.addOption(output_option);
+
+  parser.process(app);
+
+  const int n_funds = std::max(parser.value(funds_option).toInt(), 2);
+  const int n_months = std::max(parser.value(months_option).toInt(), 4);
+  const int pca_months = std::clamp(parser.value(pca_option).toInt(), 2, n_months);
+  const int repetitions = std::max(parser.value(repetitions_option).toInt(), 1);
+  const unsigned int seed = parser.value(seed_option).toUInt();
+
+  auto data = make_synthetic(n_funds, n_months, seed);
+
+  QVector<FundSeries const*> funds;
+
+  for (auto& fund : data.funds) {
+    funds.append(&fund);
+  }
+
+  const double income_tax = 15.0;
+
+  // the results of each kernel are added here so the compiler can not throw the calculations away
+
+  double checksum = 0.0;
+
+  QJsonArray kernels;
+
+  kernels.append(measure("calculate_fund", repetitions, [&]() {
+    for (auto& fund : data.funds) {
+      calculate_fund(fund, data.inflation, income_tax);
+    }
+
+    checksum += data.funds.last().net_balance.last();
+  }));
+
+  kernels.append(measure("calculate_fund_last_month", repetitions, [&]() {
+    for (auto& fund : data.funds) {
+      calculate_fund(fund, data.inflation, income_tax, fund.size() - 1);
+    }
+
+    checksum += data.funds.last().net_balance.last();
+  }));
+
+  kernels.append(measure("calculation_hash", repetitions, [&]() {
+    FundCalculation calculation;
+
+    calculation.inflation = data.inflation;
+    calculation.income_tax = income_tax;
+
+    for (auto& fund : data.funds) {
+      calculation.series = fund;
+
+      checksum += calculation_hash(calculation).at(0);
+    }
+  }));
+
+  kernels.append(measure("calculate_portfolio", repetitions, [&]() {
+    checksum += calculate_portfolio(funds, data.inflation).net_balance.last();
+  }));
+
+  kernels.append(measure("align_series", repetitions, [&]() {
+    checksum += align_series(funds, &FundSeries::net_return_perc, 0).values.sum();
+  }));
+
+  kernels.append(measure("standard_deviation", repetitions, [&]() {
+    for (auto& fund : data.funds) {
+      checksum += standard_deviation(fund.net_return_perc, 12).last();
+    }
+  }));
+
+  kernels.append(measure("correlation_coefficient", repetitions, [&]() {
+    for (int n = 1; n < data.funds.size(); n++) {
+      const auto& a = data.funds[n - 1].net_return_perc;
+      const auto& b = data.funds[n].net_return_perc;
+      const int size = std::min(a.size(), b.size());
+
+      checksum += correlation_coefficient(a.mid(a.size() - size), b.mid(b.size() - size), 12).last();
+    }
+  }));
+
+  kernels.append(measure("compound_returns", repetitions, [&]() {
+    for (auto& fund : data.funds) {
+      auto values = fund.net_return_perc;
+
+      compound_returns(values);
+
+      checksum += values.last();
+    }
+  }));
+
+  kernels.append(measure("second_derivative", repetitions, [&]() {
+    for (auto& fund : data.funds) {
+      checksum += second_derivative(fund.accumulated_net_return_perc).last();
+    }
+  }));
+
+  const auto aligned = align_series(funds, &FundSeries::net_return_perc, 0);
+
+  kernels.append(measure("correlation_matrix", repetitions, [&]() {
+    checksum += correlation_matrix(aligned.values, aligned.mask).sum();
+  }));
+
+  kernels.append(measure("pca", repetitions, [&]() { checksum += pca_explained_variance(funds, pca_months); }));
+
+  kernels.append(measure("rolling_pca", repetitions, [&]() {
+    checksum += rolling_explained_variance(aligned.values, aligned.mask, pca_months, 2).sum();
+  }));
+
+  // fewer paths than the default of the projection page so it does not dominate the run time
+
+  kernels.append(measure("projection", repetitions, [&]() {
+    const auto [returns, balance] = weighted_returns(funds);
+
+    ProjectionSettings settings;
+
+    settings.paths = 10000;
+
+    checksum += project_balance(returns, balance, settings).percentiles[2].last();
+  }));
+
+  // What happens after "Calculate Portfolio" minus the database and the charts
+
+  kernels.append(measure("recompute", repetitions, [&]() {
+    auto* fund_data = data.funds.data();
+
+#pragma omp parallel for schedule(dynamic)
+    for (int n = 0; n < n_funds; n++) {
+      calculate_fund(fund_data[n], data.inflation, income_tax);
+    }
+
+    checksum += calculate_portfolio(funds, data.inflation).net_balance.last();
+
+    const auto aligned = align_series(funds, &FundSeries::net_return_perc, 0);
+
+    checksum += correlation_matrix(aligned.values, aligned.mask).sum();
+
+    checksum += pca_explained_variance(funds, pca_months);
+  }));
+
+  int n_rows = 0;
+
+  for (auto& fund : data.funds) {
+    n_rows += fund.size();
+  }
+
+  QJsonObject output;
+
+  output["funds"] = n_funds;
+  output["months"] = n_months;
+  output["rows"] = n_rows;
+  output["pca_months"] = pca_months;
+  output["repetitions"] = repetitions;
+  output["seed"] = static_cast<double>(seed);
+  output["checksum"] = checksum;
+  output["kernels"] = kernels;
+
+  const auto json = QJsonDocument(output).toJson();
+
+  if (parser.isSet(output_option)) {
+    QFile file(parser.value(output_option));
+
+    if (!file.open(QIODevice::WriteOnly)) {
+      QTextStream(stderr) << "failed to write " << file.fileName() << "\n";
+
+      return 1;
+    }
+
+    file.write(json);
+  } else {
+    QTextStream(stdout) << json;
+  }
+
+  return 0;
+}
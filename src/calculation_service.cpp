@@ -0,0 +1,97 @@
+#include "calculation_service.hpp"
+#include <QDebug>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include "database.hpp"
+#include "schema.hpp"
+
+CalculationService::CalculationService(QObject* parent)
+    : QObject(parent), generation(std::make_shared<std::atomic<int>>(0)) {}
+
+void CalculationService::set_database(const QSqlDatabase& database) {
+  database_path = database.databaseName();
+}
+
+void CalculationService::calculate_funds(const QVector<TableFund*>& tables) {
+  const int job_generation = ++(*generation);
+
+  QVector<Job> jobs;
+
+  for (auto& table : tables) {
+    auto job = table->prepare_calculation();
+
+    if (job) {
+      jobs.append(Job(table, *job));
+    }
+  }
+
+  auto* watcher = new QFutureWatcher<QVector<Job>>(this);
+
+  connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+    watcher->deleteLater();
+
+    // a newer calculation was requested while this one was running
+
+    if (job_generation != *generation) {
+      return;
+    }
+
+    for (const auto& job : watcher->result()) {
+      if (!job.first.isNull()) {
+        job.first->apply_calculation(job.second);
+      }
+    }
+
+    emit fundsCalculated();
+  });
+
+  watcher->setFuture(QtConcurrent::run([=, generation = generation, path = database_path]() mutable {
+    // A connection can only be used by the thread that opened it. This one exists only while the job runs
+
+    if (std::any_of(jobs.begin(), jobs.end(), [](const Job& job) { return job.second.reuse_saved; })) {
+      const auto connection_name = QString("calculation_service_%1").arg(job_generation);
+
+      {
+        auto db = open_database(path, connection_name);
+
+        if (db.isOpen()) {
+          for (auto& job : jobs) {
+            if (job_generation != *generation) {
+              break;
+            }
+
+            if (job.second.read_series) {
+              job.second.calculation.series = std::get<0>(read_fund_series(db, job.second.name));
+            }
+
+            if (job.second.reuse_saved) {
+              job.second.calculation.saved_hash = load_calculation_hash(db, job.second.name);
+            }
+          }
+        } else {
+          qDebug() << "failed to open the database file in the calculation thread: " + path.toUtf8();
+        }
+      }
+
+      QSqlDatabase::removeDatabase(connection_name);
+    }
+
+    // Each fund depends only on its own rows and on the inflation series. Every job has its own copy of them so the
+    // funds can be calculated at the same time. The detach is done here and not by the threads
+
+    Job* data = jobs.data();
+
+    const int n_jobs = jobs.size();
+
+#pragma omp parallel for schedule(dynamic)
+    for (int n = 0; n < n_jobs; n++) {
+      if (job_generation != *generation) {
+        continue;
+      }
+
+      run_fund_job(data[n].second);
+    }
+
+    return jobs;
+  }));
+}
@@ -0,0 +1,44 @@
+#ifndef CALCULATION_SERVICE_HPP
+#define CALCULATION_SERVICE_HPP
+
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QSqlDatabase>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "table_fund.hpp"
+
+/*
+  Runs the investment table calculations on the Qt thread pool. The tables that were already shown are read from
+  their models on the GUI thread before the job is started and their models and charts are updated on the GUI thread
+  once it finishes. The rows of the other tables are read by the job. Their models are loaded only when they are
+  shown. Everything in between, the saved hashes lookup, the hashing, the calculation and the chart points, is done by
+  the job. It reads the database through its own connection. A new request makes the running one stop and discard its
+  results.
+*/
+
+class CalculationService : public QObject {
+  Q_OBJECT
+ public:
+  explicit CalculationService(QObject* parent = nullptr);
+
+  void set_database(const QSqlDatabase& database);
+
+  void calculate_funds(const QVector<TableFund*>& tables);
+
+ signals:
+  void fundsCalculated();
+
+ private:
+  using Job = QPair<QPointer<TableFund>, FundJob>;
+
+  QString database_path;
+
+  // shared with the worker threads. It may outlive the service while a job is finishing
+
+  std::shared_ptr<std::atomic<int>> generation;
+};
+
+#endif
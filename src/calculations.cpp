@@ -0,0 +1,203 @@
+#include "calculations.hpp"
+#include <QCryptographicHash>
+#include <algorithm>
+
+void calculate_fund(FundSeries& series, const BenchmarkSeries& inflation, const double& income_tax, const int& first) {
+  const int start = std::max(first, 0);
+
+  double accumulated_deposit = (start > 0) ? series.accumulated_deposit[start - 1] : 0.0;
+  double accumulated_withdrawal = (start > 0) ? series.accumulated_withdrawal[start - 1] : 0.0;
+  double accumulated_gross_return = (start > 0) ? series.accumulated_gross_return[start - 1] : 0.0;
+  double accumulated_net_return = (start > 0) ? series.accumulated_net_return[start - 1] : 0.0;
+  double net_return_product = (start > 0) ? series.accumulated_net_return_perc[start - 1] * 0.01 + 1.0 : 1.0;
+  double real_return_product = (start > 0) ? series.accumulated_real_return_perc[start - 1] * 0.01 + 1.0 : 1.0;
+
+  for (int n = start; n < series.size(); n++) {
+    const double deposit = series.deposit[n];
+    const double withdrawal = series.withdrawal[n];
+    const double starting_balance = series.starting_balance[n];
+    const double ending_balance = series.ending_balance[n];
+
+    accumulated_deposit += deposit;
+    accumulated_withdrawal += withdrawal;
+
+    const double gross_return = ending_balance - starting_balance - deposit + withdrawal;
+
+    accumulated_gross_return += gross_return;
+
+    const double net_return = gross_return * (1.0 - 0.01 * income_tax);
+
+    const double net_return_perc = 100 * net_return / (starting_balance + deposit - withdrawal);
+
+    double real_return_perc = net_return_perc;
+
+    const int i = inflation.find(series.months[n]);
+
+    if (i != -1) {
+      real_return_perc = 100.0 * (net_return_perc - inflation.values[i]) / (100.0 + inflation.values[i]);
+    }
+
+    accumulated_net_return += net_return;
+
+    net_return_product *= net_return_perc * 0.01 + 1.0;
+    real_return_product *= real_return_perc * 0.01 + 1.0;
+
+    series.accumulated_deposit[n] = accumulated_deposit;
+    series.accumulated_withdrawal[n] = accumulated_withdrawal;
+    series.accumulated_gross_return[n] = accumulated_gross_return;
+    series.net_deposit[n] = accumulated_deposit - accumulated_withdrawal;
+    series.net_balance[n] = ending_balance - accumulated_gross_return * 0.01 * income_tax;
+    series.net_return[n] = net_return;
+    series.net_return_perc[n] = net_return_perc;
+    series.accumulated_net_return[n] = accumulated_net_return;
+    series.accumulated_net_return_perc[n] = (net_return_product - 1.0) * 100;
+    series.real_return_perc[n] = real_return_perc;
+    series.accumulated_real_return_perc[n] = (real_return_product - 1.0) * 100;
+  }
+}
+
+void calculate_fund(FundCalculation& calculation) {
+  calculation.hash = calculation_hash(calculation);
+
+  calculation.up_to_date = !calculation.saved_hash.isEmpty() && calculation.hash == calculation.saved_hash;
+
+  if (calculation.up_to_date) {
+    auto& series = calculation.series;
+
+    double accumulated_gross_return = 0.0;
+
+    for (int n = 0; n < series.size(); n++) {
+      accumulated_gross_return +=
+          series.ending_balance[n] - series.starting_balance[n] - series.deposit[n] + series.withdrawal[n];
+
+      series.accumulated_gross_return[n] = accumulated_gross_return;
+    }
+
+    return;
+  }
+
+  calculate_fund(calculation.series, calculation.inflation, calculation.income_tax, calculation.first);
+}
+
+auto calculate_portfolio(const QVector<FundSeries const*>& funds, const BenchmarkSeries& inflation) -> FundSeries {
+  // months available in each investment table
+
+  QVector<int> months;
+
+  for (auto& fund : funds) {
+    months.append(fund->months);
+  }
+
+  std::sort(months.begin(), months.end());
+
+  months.erase(std::unique(months.begin(), months.end()), months.end());
+
+  FundSeries portfolio;
+
+  portfolio.resize(months.size());
+
+  // values summed over the investments
+
+  const std::array<FundSeries::Column, 8> summed_columns = {
+      &FundSeries::deposit,          &FundSeries::withdrawal,          &FundSeries::starting_balance,
+      &FundSeries::ending_balance,   &FundSeries::accumulated_deposit, &FundSeries::accumulated_withdrawal,
+      &FundSeries::net_deposit,      &FundSeries::net_balance};
+
+  // The fund series and the months are sorted so each fund is walked only once
+
+  QVector<int> cursors(funds.size(), 0);
+
+  double accumulated_net_return = 0.0;
+  double net_return_product = 1.0;
+  double real_return_product = 1.0;
+
+  for (int n = 0; n < months.size(); n++) {
+    const int month = months[n];
+
+    portfolio.months[n] = month;
+    portfolio.dates[n] = month_key_to_epoch(month);
+
+    double net_return = 0.0;
+
+    for (int m = 0; m < funds.size(); m++) {
+      const auto& fund = *funds[m];
+
+      int& idx = cursors[m];
+
+      while (idx < fund.size() && fund.months[idx] < month) {
+        idx++;
+      }
+
+      if (idx < fund.size() && fund.months[idx] == month) {
+        for (const auto& column : summed_columns) {
+          (portfolio.*column)[n] += (fund.*column)[idx];
+        }
+
+        net_return += fund.net_return[idx];
+      }
+    }
+
+    const double net_return_perc = 100 * net_return /
+                                   (portfolio.starting_balance[n] + portfolio.deposit[n] - portfolio.withdrawal[n]);
+
+    double real_return_perc = net_return_perc;
+
+    const int i = inflation.find(month);
+
+    if (i != -1) {
+      real_return_perc = 100.0 * (net_return_perc - inflation.values[i]) / (100.0 + inflation.values[i]);
+    }
+
+    accumulated_net_return += net_return;
+
+    net_return_product *= net_return_perc * 0.01 + 1.0;
+    real_return_product *= real_return_perc * 0.01 + 1.0;
+
+    portfolio.net_return[n] = net_return;
+    portfolio.net_return_perc[n] = net_return_perc;
+    portfolio.accumulated_net_return[n] = accumulated_net_return;
+    portfolio.accumulated_net_return_perc[n] = (net_return_product - 1.0) * 100;
+    portfolio.real_return_perc[n] = real_return_perc;
+    portfolio.accumulated_real_return_perc[n] = (real_return_product - 1.0) * 100;
+  }
+
+  return portfolio;
+}
+
+auto calculation_hash(const FundCalculation& calculation) -> QByteArray {
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+
+  const auto add_vector = [&](const auto& v) {
+    hash.addData(reinterpret_cast<const char*>(v.constData()), static_cast<int>(v.size() * sizeof(v[0])));
+  };
+
+  const auto& series = calculation.series;
+
+  add_vector(series.dates);
+  add_vector(series.deposit);
+  add_vector(series.withdrawal);
+  add_vector(series.starting_balance);
+  add_vector(series.ending_balance);
+
+  hash.addData(reinterpret_cast<const char*>(&calculation.income_tax), sizeof(calculation.income_tax));
+
+  add_vector(calculation.inflation.months);
+  add_vector(calculation.inflation.values);
+
+  return hash.result();
+}
+
+auto portfolio_hash(const QVector<QString>& names, const QVector<QByteArray>& hashes) -> QByteArray {
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+
+  for (int n = 0; n < names.size(); n++) {
+    if (hashes[n].isEmpty()) {
+      return {};
+    }
+
+    hash.addData(names[n].toUtf8());
+    hash.addData(hashes[n]);
+  }
+
+  return hash.result();
+}
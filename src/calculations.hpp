@@ -0,0 +1,56 @@
+#ifndef CALCULATIONS_HPP
+#define CALCULATIONS_HPP
+
+#include <QByteArray>
+#include "benchmark_cache.hpp"
+#include "fund_series.hpp"
+
+/*
+  Calculates the derived columns of an investment series from its deposit, withdrawal and balance columns. Rows before
+  "first" are assumed to be up to date and are used as the starting point of the accumulated columns. This is what
+  allows an edit in the latest months to be recalculated without going through the whole history.
+*/
+
+void calculate_fund(FundSeries& series, const BenchmarkSeries& inflation, const double& income_tax, const int& first = 0);
+
+// Everything calculate_fund() needs. It is a copy of the table data so it can be processed outside of the GUI thread
+
+struct FundCalculation {
+  FundSeries series;
+  BenchmarkSeries inflation;
+  double income_tax = 0.0;
+  int first = 0;
+  int id = 0;  // used by the table to ignore the results of outdated calculations
+
+  QByteArray hash;  // see calculation_hash(). Set by calculate_fund()
+
+  // hash saved in the database together with the derived columns. Empty if the saved columns can not be reused
+
+  QByteArray saved_hash;
+
+  // The derived columns saved in the database were calculated from these same inputs. Only the columns that are not
+  // saved have to be calculated. Set by calculate_fund()
+
+  bool up_to_date = false;
+};
+
+// hashes the inputs and calculates the derived columns that are not up to date. Can be called from any thread
+
+void calculate_fund(FundCalculation& calculation);
+
+/*
+  Sum of the investments month by month. Only the investments that have a row in a given month contribute to it. The
+  percentages and the accumulated columns are calculated from the summed values.
+*/
+
+auto calculate_portfolio(const QVector<FundSeries const*>& funds, const BenchmarkSeries& inflation) -> FundSeries;
+
+// Hash of everything the derived columns depend on: dates, deposits, withdrawals, balances, income tax and inflation
+
+auto calculation_hash(const FundCalculation& calculation) -> QByteArray;
+
+// Hash of the results the portfolio was built from. Empty if one of the investments does not have a results hash
+
+auto portfolio_hash(const QVector<QString>& names, const QVector<QByteArray>& hashes) -> QByteArray;
+
+#endif
@@ -5,11 +5,33 @@
 #include "qdatetimeaxis.h"
 #include "qnamespace.h"
 
+namespace {
+
+// sorted copy of the points kept in the series. resample_series() takes the points from it
+
+void store_series_points(QXYSeries* series, const QVector<QPointF>& points) {
+  QPolygonF sorted(points);
+
+  // the tables are sorted in descending date order. The downsampling needs ascending x values
+
+  if (!std::is_sorted(sorted.begin(), sorted.end(), [](const QPointF& a, const QPointF& b) { return a.x() < b.x(); })) {
+    std::stable_sort(sorted.begin(), sorted.end(), [](const QPointF& a, const QPointF& b) { return a.x() < b.x(); });
+  }
+
+  series->setProperty("full_points", sorted);
+}
+
+}  // namespace
+
 void clear_chart(QChart* chart) {
   chart->removeAllSeries();
 
+  // removeAxis() gives the axis ownership back to us
+
   for (auto& axis : chart->axes()) {
     chart->removeAxis(axis);
+
+    delete axis;
   }
 }
 
@@ -31,148 +53,257 @@ void add_axes_to_chart(QChart* chart, const QString& ytitle) {
 
   chart->addAxis(axis_x, Qt::AlignBottom);
   chart->addAxis(axis_y, Qt::AlignLeft);
+
+  // zooming with the rubber band and resizing the window change how many points can actually be seen
+
+  QObject::connect(axis_x, &QDateTimeAxis::rangeChanged, chart, [=]() { resample_chart(chart); });
+  QObject::connect(chart, &QChart::plotAreaChanged, axis_x, [=]() { resample_chart(chart); });
 }
 
-auto add_series_to_chart(QChart* chart, const Model* tmodel, const QString& series_name, const QString& column_name)
+auto add_points_to_chart(QChart* chart, const QVector<QPointF>& points, const QString& series_name, const bool& fit_x)
     -> QLineSeries* {
   const auto series = new QLineSeries();
 
   series->setName(series_name.toLower());
 
-  double ymin = dynamic_cast<QValueAxis*>(chart->axes(Qt::Vertical)[0])->min();
-  double ymax = dynamic_cast<QValueAxis*>(chart->axes(Qt::Vertical)[0])->max();
-  qint64 xmin = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0])->min().toMSecsSinceEpoch();
-  qint64 xmax = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0])->max().toMSecsSinceEpoch();
-
-  for (int n = 0; n < tmodel->rowCount(); n++) {
-    const auto qdt = QDateTime::fromString(tmodel->record(n).value("date").toString(), "MM/yyyy");
-
-    const auto epoch_in_ms = qdt.toMSecsSinceEpoch();
-
-    const double v = tmodel->record(n).value(column_name).toDouble();
-
-    if (!chart->series().empty()) {
-      ymin = std::min(ymin, v);
-      ymax = std::max(ymax, v);
-      xmin = std::min(xmin, epoch_in_ms);
-      xmax = std::max(xmax, epoch_in_ms);
-    } else {
-      if (n == 0) {
-        ymin = v;
-        ymax = v;
-        xmin = epoch_in_ms;
-        xmax = epoch_in_ms;
-      } else {
-        ymin = std::min(ymin, v);
-        ymax = std::max(ymax, v);
-        xmin = std::min(xmin, epoch_in_ms);
-        xmax = std::max(xmax, epoch_in_ms);
-      }
-    }
-
-    series->append(epoch_in_ms, v);
-  }
+  const bool first_series = chart->series().empty();
 
   chart->addSeries(series);
 
   series->attachAxis(chart->axes(Qt::Horizontal)[0]);
   series->attachAxis(chart->axes(Qt::Vertical)[0]);
 
-  chart->axes(Qt::Vertical)[0]->setRange(ymin - 0.05 * fabs(ymin), ymax + 0.05 * fabs(ymax));
-  chart->axes(Qt::Horizontal)[0]->setRange(QDateTime::fromMSecsSinceEpoch(xmin), QDateTime::fromMSecsSinceEpoch(xmax));
+  // The series is filled only after the axes ranges are set. This way the points are downsampled only once
+
+  store_series_points(series, points);
+
+  if (points.empty()) {
+    return series;
+  }
+
+  auto* const axis_x = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0]);
+  auto* const axis_y = dynamic_cast<QValueAxis*>(chart->axes(Qt::Vertical)[0]);
+
+  const auto [xmin_it, xmax_it] = std::minmax_element(
+      points.begin(), points.end(), [](const QPointF& a, const QPointF& b) { return a.x() < b.x(); });
+  const auto [ymin_it, ymax_it] = std::minmax_element(
+      points.begin(), points.end(), [](const QPointF& a, const QPointF& b) { return a.y() < b.y(); });
+
+  auto xmin = static_cast<qint64>(xmin_it->x());
+  auto xmax = static_cast<qint64>(xmax_it->x());
+  double ymin = ymin_it->y();
+  double ymax = ymax_it->y();
+
+  if (!first_series) {
+    xmin = std::min(xmin, axis_x->min().toMSecsSinceEpoch());
+    xmax = std::max(xmax, axis_x->max().toMSecsSinceEpoch());
+    ymin = std::min(ymin, axis_y->min());
+    ymax = std::max(ymax, axis_y->max());
+  }
+
+  axis_y->setRange(ymin - 0.05 * fabs(ymin), ymax + 0.05 * fabs(ymax));
+
+  if (fit_x) {
+    axis_x->setRange(QDateTime::fromMSecsSinceEpoch(xmin), QDateTime::fromMSecsSinceEpoch(xmax));
+  }
+
+  resample_series(series);
 
   return series;
 }
 
-auto add_series_to_chart(QChart* chart,
-                         const QVector<int>& dates,
-                         const QVector<double>& values,
-                         const QString& series_name) -> QLineSeries* {
-  const auto series = new QLineSeries();
+auto series_points(const QXYSeries* series) -> QVector<QPointF> {
+  return series->property("full_points").value<QPolygonF>();
+}
 
-  series->setName(series_name.toLower());
+void set_series_points(QXYSeries* series, const QVector<QPointF>& points) {
+  store_series_points(series, points);
+
+  resample_series(series);
+}
+
+void resample_series(QXYSeries* series) {
+  const auto points = series_points(series);
+
+  auto* const chart = series->chart();
+
+  if (chart == nullptr || chart->axes(Qt::Horizontal).empty()) {
+    series->replace(points);
+
+    return;
+  }
+
+  auto* const axis_x = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0]);
+
+  if (axis_x == nullptr) {
+    series->replace(points);
+
+    return;
+  }
+
+  // only the visible points plus one at each side so that the line still reaches the plot borders
+
+  const double xmin = axis_x->min().toMSecsSinceEpoch();
+  const double xmax = axis_x->max().toMSecsSinceEpoch();
+
+  auto first = std::lower_bound(points.begin(), points.end(), xmin,
+                                [](const QPointF& p, const double& x) { return p.x() < x; });
+  auto last = std::upper_bound(points.begin(), points.end(), xmax,
+                               [](const double& x, const QPointF& p) { return x < p.x(); });
+
+  if (first != points.begin()) {
+    first--;
+  }
+
+  if (last != points.end()) {
+    last++;
+  }
+
+  // Nothing is gained by drawing more than one point per pixel. Before the chart is shown the plot area is empty and
+  // all the points are kept
+
+  const int width = static_cast<int>(chart->plotArea().width());
+
+  const QVector<QPointF> visible(first, last);
+
+  series->replace((width > 0) ? lttb(visible, width) : visible);
+}
+
+void resample_chart(QChart* chart) {
+  for (auto& s : chart->series()) {
+    auto* const series = qobject_cast<QXYSeries*>(s);
+
+    if (series != nullptr && series->property("full_points").isValid()) {
+      resample_series(series);
+    }
+  }
+}
+
+auto lttb(const QVector<QPointF>& points, const int& threshold) -> QVector<QPointF> {
+  const int n_points = points.size();
+
+  if (threshold >= n_points || threshold < 3) {
+    return points;
+  }
+
+  QVector<QPointF> sampled;
+
+  sampled.reserve(threshold);
+
+  // the first and the last points are always kept. The other ones are split in threshold - 2 buckets
+
+  const double bucket_size = static_cast<double>(n_points - 2) / (threshold - 2);
+
+  int a = 0;
+
+  sampled.append(points[0]);
+
+  for (int i = 0; i < threshold - 2; i++) {
+    // average of the next bucket. It is the third vertex of the triangles
+
+    const int avg_start = static_cast<int>((i + 1) * bucket_size) + 1;
+    const int avg_end = std::min(static_cast<int>((i + 2) * bucket_size) + 1, n_points);
+
+    double avg_x = 0.0;
+    double avg_y = 0.0;
+
+    for (int j = avg_start; j < avg_end; j++) {
+      avg_x += points[j].x();
+      avg_y += points[j].y();
+    }
+
+    avg_x /= std::max(avg_end - avg_start, 1);
+    avg_y /= std::max(avg_end - avg_start, 1);
+
+    // the point of the current bucket that makes the largest triangle with the last selected point and the average
 
-  double ymin = dynamic_cast<QValueAxis*>(chart->axes(Qt::Vertical)[0])->min();
-  double ymax = dynamic_cast<QValueAxis*>(chart->axes(Qt::Vertical)[0])->max();
-  qint64 xmin = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0])->min().toMSecsSinceEpoch();
-  qint64 xmax = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0])->max().toMSecsSinceEpoch();
-
-  for (int n = 0; n < dates.size(); n++) {
-    const double v = values[n];
-    const qint64 d = static_cast<qint64>(dates[n]) * 1000;
-
-    if (!chart->series().empty()) {
-      ymin = std::min(ymin, v);
-      ymax = std::max(ymax, v);
-      xmin = std::min(xmin, d);
-      xmax = std::max(xmax, d);
-    } else {
-      if (n == 0) {
-        ymin = v;
-        ymax = v;
-        xmin = d;
-        xmax = d;
-      } else {
-        ymin = std::min(ymin, v);
-        ymax = std::max(ymax, v);
-        xmin = std::min(xmin, d);
-        xmax = std::max(xmax, d);
+    const int bucket_start = static_cast<int>(i * bucket_size) + 1;
+    const int bucket_end = static_cast<int>((i + 1) * bucket_size) + 1;
+
+    const QPointF& pa = points[a];
+
+    double max_area = -1.0;
+    int selected = bucket_start;
+
+    for (int j = bucket_start; j < bucket_end; j++) {
+      const double area =
+          std::fabs((pa.x() - avg_x) * (points[j].y() - pa.y()) - (pa.x() - points[j].x()) * (avg_y - pa.y()));
+
+      if (area > max_area) {
+        max_area = area;
+        selected = j;
       }
     }
 
-    series->append(d, v);
+    sampled.append(points[selected]);
+
+    a = selected;
   }
 
-  chart->addSeries(series);
+  sampled.append(points[n_points - 1]);
 
-  series->attachAxis(chart->axes(Qt::Horizontal)[0]);
-  series->attachAxis(chart->axes(Qt::Vertical)[0]);
+  return sampled;
+}
 
-  chart->axes(Qt::Vertical)[0]->setRange(ymin - 0.05 * fabs(ymin), ymax + 0.05 * fabs(ymax));
-  chart->axes(Qt::Horizontal)[0]->setRange(QDateTime::fromMSecsSinceEpoch(xmin), QDateTime::fromMSecsSinceEpoch(xmax));
+auto add_series_to_chart(QChart* chart, const Model* tmodel, const QString& series_name, const QString& column_name)
+    -> QLineSeries* {
+  const int column = tmodel->fieldIndex(column_name);
 
-  return series;
+  QVector<QPointF> points;
+
+  points.reserve(tmodel->rowCount());
+
+  for (int n = 0; n < tmodel->rowCount(); n++) {
+    const auto epoch_in_ms = static_cast<qint64>(tmodel->epoch(n)) * 1000;
+
+    points.append(QPointF(epoch_in_ms, tmodel->data(tmodel->index(n, column)).toDouble()));
+  }
+
+  return add_points_to_chart(chart, points, series_name);
+}
+
+auto add_series_to_chart(QChart* chart,
+                         const QVector<int>& dates,
+                         const QVector<double>& values,
+                         const QString& series_name) -> QLineSeries* {
+  return add_points_to_chart(chart, dates_to_points(dates, values), series_name);
+}
+
+auto dates_to_points(const QVector<int>& dates, const QVector<double>& values) -> QVector<QPointF> {
+  QVector<QPointF> points(std::min(dates.size(), values.size()));
+
+  for (int n = 0; n < points.size(); n++) {
+    points[n] = QPointF(static_cast<qint64>(dates[n]) * 1000, values[n]);
+  }
+
+  return points;
 }
 
 auto add_tables_barseries_to_chart(QChart* chart,
                                    const QVector<TableFund const*>& tables,
-                                   const QVector<int>& list_dates,
+                                   const QVector<int>& months,
                                    const QString& series_name,
                                    const QString& column_name)
     -> std::tuple<QStackedBarSeries*, QVector<QBarSet*>, QStringList> {
   QVector<QBarSet*> barsets;
 
+  const auto column = FundSeries::column(column_name);
+
   for (auto& table : tables) {
     barsets.append(new QBarSet(table->name));
   }
 
   QStringList categories;
 
-  for (auto& date : list_dates) {
-    const auto qdt = QDateTime::fromSecsSinceEpoch(date);
-
-    const QString date_month = qdt.toString("MM/yyyy");
-
-    categories.append(date_month);
+  for (auto& month : months) {
+    categories.append(month_key_to_string(month));
 
     for (int m = 0; m < tables.size(); m++) {
-      bool has_date = false;
-
-      for (int n = tables[m]->model->rowCount() - 1; n >= 0; n--) {
-        const QString tdate = tables[m]->model->record(n).value("date").toString();
+      const auto& fund = tables[m]->series;
 
-        if (date_month == tdate) {
-          barsets[m]->append(tables[m]->model->record(n).value(column_name).toDouble());
+      const int idx = fund.find(month);
 
-          has_date = true;
-
-          break;
-        }
-      }
-
-      if (!has_date) {
-        barsets[m]->append(0.0);
-      }
+      barsets[m]->append((idx != -1) ? (fund.*column)[idx] : 0.0);
     }
   }
 
@@ -211,36 +342,34 @@ auto add_tables_barseries_to_chart(QChart* chart,
   return {series, barsets, categories};
 }
 
-auto get_unique_months_from_db(const QSqlDatabase& db,
-                               const QVector<TableFund const*>& tables,
-                               const int& last_n_months) -> QVector<int> {
-  QSet<int> set;
+auto get_unique_months(const QVector<TableFund const*>& tables, const int& last_n_months) -> QVector<int> {
+  QVector<int> list;
 
-  for (auto& table : tables) {
-    if (set.size() == last_n_months) {
-      break;
-    }
+  if (tables.empty() || last_n_months <= 0) {
+    return list;
+  }
+
+  // The series are sorted in ascending order. The last n unique months of all of them are among the last n months of
+  // each one
 
-    // making sure all the latest data was saved to the database
+  for (auto& table : tables) {
+    const auto& months = table->series.months;
 
-    table->model->submitAll();
+    list.append(months.mid(std::max(months.size() - last_n_months, 0)));
+  }
 
-    auto query = QSqlQuery(db);
+  std::sort(list.begin(), list.end());
 
-    query.prepare("select distinct date from " + table->name + " order by date desc");
+  list.erase(std::unique(list.begin(), list.end()), list.end());
 
-    if (query.exec()) {
-      while (query.next() && set.size() < last_n_months) {
-        set.insert(query.value(0).toInt());
-      }
-    } else {
-      qDebug() << table->model->lastError().text().toUtf8();
-    }
-  }
+  return list.mid(std::max(list.size() - last_n_months, 0));
+}
 
-  QVector<int> list = QVector<int>::fromList(set.values());
+auto months_to_dates(const QVector<int>& months) -> QVector<int> {
+  QVector<int> dates(months.size());
 
-  std::sort(list.begin(), list.end());
+  std::transform(months.begin(), months.end(), dates.begin(),
+                 [](const int& month) { return month_key_to_epoch(month); });
 
-  return list;
+  return dates;
 }
\ No newline at end of file
@@ -10,6 +10,32 @@ void clear_chart(QChart* chart);
 
 void add_axes_to_chart(QChart* chart, const QString& ytitle);
 
+/*
+  Adds a line series with all the points at once. The vertical axis range and, if fit_x is true, the horizontal axis
+  range are extended to include the new points. The axes have to be added with add_axes_to_chart() before.
+*/
+
+auto add_points_to_chart(QChart* chart,
+                         const QVector<QPointF>& points,
+                         const QString& series_name,
+                         const bool& fit_x = true) -> QLineSeries*;
+
+// All the points of a series created by add_points_to_chart(). The series itself may hold only a downsampled subset
+
+auto series_points(const QXYSeries* series) -> QVector<QPointF>;
+
+void set_series_points(QXYSeries* series, const QVector<QPointF>& points);
+
+// Fills the series with the points inside the horizontal axis range downsampled to the plot area width
+
+void resample_series(QXYSeries* series);
+
+void resample_chart(QChart* chart);
+
+// Largest-Triangle-Three-Buckets downsampling. The points have to be sorted by their x value
+
+auto lttb(const QVector<QPointF>& points, const int& threshold) -> QVector<QPointF>;
+
 auto add_series_to_chart(QChart* chart, const Model* tmodel, const QString& series_name, const QString& column_name)
     -> QLineSeries*;
 
@@ -18,15 +44,24 @@ auto add_series_to_chart(QChart* chart,
                          const QVector<double>& values,
                          const QString& series_name) -> QLineSeries*;
 
+// chart points from dates in seconds since epoch. The x values are in milliseconds as QDateTimeAxis expects
+
+auto dates_to_points(const QVector<int>& dates, const QVector<double>& values) -> QVector<QPointF>;
+
 auto add_tables_barseries_to_chart(QChart* chart,
                                    const QVector<TableFund const*>& tables,
-                                   const QVector<int>& list_dates,
+                                   const QVector<int>& months,
                                    const QString& series_name,
                                    const QString& column_name)
     -> std::tuple<QStackedBarSeries*, QVector<QBarSet*>, QStringList>;
 
-auto get_unique_months_from_db(const QSqlDatabase& db,
-                               const QVector<TableFund const*>& tables,
-                               const int& last_n_months) -> QVector<int>;
+// Month keys of the last n months found in the fund tables sorted in ascending order. They come from the series of
+// the tables so they also include the rows that were not saved yet
+
+auto get_unique_months(const QVector<TableFund const*>& tables, const int& last_n_months) -> QVector<int>;
+
+// chart x values for a list of month keys
+
+auto months_to_dates(const QVector<int>& months) -> QVector<int>;
 
 #endif
\ No newline at end of file
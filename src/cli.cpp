@@ -0,0 +1,201 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTextStream>
+#include "benchmark_cache.hpp"
+#include "calculations.hpp"
+#include "database.hpp"
+#include "schema.hpp"
+
+/*
+  Recalculates all the investment tables and the portfolio without starting the graphical interface. The results are
+  written as csv to the standard output or to one file per table.
+*/
+
+namespace {
+
+void write_csv(QTextStream& stream, const FundSeries& series) {
+  stream << "date";
+
+  for (const auto& column : FundSeries::columns) {
+    stream << "," << column.first;
+  }
+
+  stream << "\n";
+
+  for (int n = 0; n < series.size(); n++) {
+    stream << month_key_to_string(series.months[n]);
+
+    for (const auto& column : FundSeries::columns) {
+      stream << "," << QString::number((series.*column.second)[n], 'f', 6);
+    }
+
+    stream << "\n";
+  }
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  QCoreApplication app(argc, argv);
+
+  // the same names used by the graphical interface so the database path and the income tax settings are shared
+
+  QCoreApplication::setOrganizationName("wwmm");
+  QCoreApplication::setApplicationName("ViewProfit");
+
+  QCommandLineParser parser;
+
+  parser.setApplicationDescription("Recalculates the investment tables and the portfolio");
+  parser.addHelpOption();
+
+  QCommandLineOption database_option({"d", "database"}, "Database file.", "file",
+                                     QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+                                         "/viewprofit.sqlite");
+  QCommandLineOption output_option({"o", "output"}, "Directory where one csv file per table is written.", "directory");
+  QCommandLineOption save_option({"s", "save"}, "Save the results to the database.");
+  QCommandLineOption quiet_option({"q", "quiet"}, "Do not write the results.");
+
+  parser.addOption(database_option);
+  parser.addOption(output_option);
+  parser.addOption(save_option);
+  parser.addOption(quiet_option);
+
+  parser.process(app);
+
+  QTextStream err(stderr);
+
+  if (!QFile::exists(parser.value(database_option))) {
+    err << "database file not found: " << parser.value(database_option) << "\n";
+
+    return 1;
+  }
+
+  auto db = open_database(parser.value(database_option));
+
+  if (!db.isOpen()) {
+    err << "failed to open the database file: " << parser.value(database_option) << "\n";
+
+    return 1;
+  }
+
+  create_metadata_tables(db);
+  migrate_metadata(db);
+
+  BenchmarkCache benchmarks;
+
+  benchmarks.set_database(db);
+
+  const auto inflation = benchmarks.get("inflation");
+
+  const auto names = load_table_names(db, TableType::Investment);
+
+  QElapsedTimer timer;
+
+  timer.start();
+
+  QVector<FundCalculation> calculations(names.size());
+  QVector<QVector<int>> ids(names.size());
+
+  QSettings qsettings;
+
+  for (int n = 0; n < names.size(); n++) {
+    std::tie(calculations[n].series, ids[n]) = read_fund_series(db, names[n]);
+
+    qsettings.beginGroup(names[n]);
+
+    calculations[n].income_tax = qsettings.value("income_tax", 0.0).toDouble();
+
+    qsettings.endGroup();
+
+    calculations[n].inflation = inflation;
+  }
+
+  const auto load_time = timer.restart();
+
+  FundCalculation* data = calculations.data();
+
+  const int n_funds = calculations.size();
+
+#pragma omp parallel for schedule(dynamic)
+  for (int n = 0; n < n_funds; n++) {
+    calculate_fund(data[n]);
+  }
+
+  QVector<FundSeries const*> funds;
+
+  for (auto& calculation : calculations) {
+    funds.append(&calculation.series);
+  }
+
+  const auto portfolio = calculate_portfolio(funds, inflation);
+
+  const auto calculation_time = timer.restart();
+
+  if (parser.isSet(save_option)) {
+    for (int n = 0; n < names.size(); n++) {
+      if (!write_derived_columns(db, names[n], calculations[n].series, ids[n])) {
+        err << "failed to save table " << names[n] << "\n";
+      }
+    }
+
+    if (!portfolio.empty() && !write_fund_series(db, "portfolio", portfolio)) {
+      err << "failed to save table portfolio\n";
+    }
+  }
+
+  if (!parser.isSet(quiet_option)) {
+    const auto output_dir = parser.value(output_option);
+
+    auto write_table = [&](const QString& name, const FundSeries& series) {
+      if (output_dir.isEmpty()) {
+        QTextStream out(stdout);
+
+        out << "# " << name << "\n";
+
+        write_csv(out, series);
+
+        out << "\n";
+
+        return;
+      }
+
+      QDir().mkpath(output_dir);
+
+      QFile file(output_dir + "/" + name + ".csv");
+
+      if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        err << "failed to write " << file.fileName() << "\n";
+
+        return;
+      }
+
+      QTextStream out(&file);
+
+      write_csv(out, series);
+    };
+
+    for (int n = 0; n < names.size(); n++) {
+      write_table(names[n], calculations[n].series);
+    }
+
+    write_table("portfolio", portfolio);
+  }
+
+  const auto output_time = timer.elapsed();
+
+  int n_rows = 0;
+
+  for (auto& fund : funds) {
+    n_rows += fund->size();
+  }
+
+  err << "investments: " << n_funds << " rows: " << n_rows << " load: " << load_time
+      << " ms calculation: " << calculation_time << " ms output: " << output_time << " ms\n";
+
+  return 0;
+}
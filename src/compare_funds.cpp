@@ -55,7 +55,9 @@ void CompareFunds::make_chart_net_balance_pie() {
   std::deque<QPair<QString, double>> deque;
 
   for (auto& table : tables) {
-    deque.emplace_back(table->name, table->model->record(0).value("net_balance").toDouble());
+    if (!table->series.empty()) {
+      deque.emplace_back(table->name, table->series.net_balance.back());
+    }
   }
 
   make_pie(deque);
@@ -65,7 +67,11 @@ void CompareFunds::make_chart_net_return_pie() {
   std::deque<QPair<QString, double>> deque;
 
   for (auto& table : tables) {
-    double value = table->model->record(0).value("net_return").toDouble();
+    if (table->series.empty()) {
+      continue;
+    }
+
+    double value = table->series.net_return.back();
 
     if (value > 0) {
       deque.emplace_back(table->name, value);
@@ -80,47 +86,19 @@ void CompareFunds::make_chart_net_return() {
 
   add_axes_to_chart(chart, "%");
 
-  for (auto& table : tables) {
-    QVector<int> dates;
-    QVector<double> values;
-
-    for (int n = 0; n < table->model->rowCount() && n < spinbox_months->value(); n++) {
-      auto qdt = QDateTime::fromString(table->model->record(n).value("date").toString(), "MM/yyyy");
-
-      dates.append(qdt.toSecsSinceEpoch());
-      values.append(table->model->record(n).value("net_return_perc").toDouble());
-    }
+  const auto& cache = analysis();
 
-    if (dates.size() < 2) {
-      continue;
+  for (auto& fund : cache.funds) {
+    if (fund.dates.size() >= 2) {
+      add_line_series(fund.dates, fund.net_return_perc, fund.name);
     }
-
-    auto* const s = add_series_to_chart(chart, dates, values, table->name);
-
-    connect(s, &QLineSeries::hovered, this,
-            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
   }
 
   // portfolio
 
-  QVector<int> dates;
-  QVector<double> values;
-
-  for (int n = 0; n < portfolio->model->rowCount() && n < spinbox_months->value(); n++) {
-    auto qdt = QDateTime::fromString(portfolio->model->record(n).value("date").toString(), "MM/yyyy");
-
-    dates.append(qdt.toSecsSinceEpoch());
-    values.append(portfolio->model->record(n).value("net_return_perc").toDouble());
-  }
-
-  if (dates.size() < 2) {
-    return;
+  if (cache.portfolio.dates.size() >= 2) {
+    add_line_series(cache.portfolio.dates, cache.portfolio.net_return_perc, cache.portfolio.name);
   }
-
-  auto* const s = add_series_to_chart(chart, dates, values, portfolio->name);
-
-  connect(s, &QLineSeries::hovered, this,
-          [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
 }
 
 void CompareFunds::make_chart_net_return_volatility() {
@@ -128,60 +106,30 @@ void CompareFunds::make_chart_net_return_volatility() {
 
   add_axes_to_chart(chart, "%");
 
-  for (auto& table : tables) {
-    QVector<int> dates;
-    QVector<double> values;
-
-    for (int n = 0; n < table->model->rowCount() && n < spinbox_months->value(); n++) {
-      auto qdt = QDateTime::fromString(table->model->record(n).value("date").toString(), "MM/yyyy");
+  const auto& cache = analysis();
 
-      dates.append(qdt.toSecsSinceEpoch());
-      values.append(table->model->record(n).value("net_return_perc").toDouble());
+  for (auto& fund : cache.funds) {
+    if (fund.dates.size() >= 2) {
+      add_line_series(fund.dates, fund.volatility, fund.name);
     }
-
-    if (dates.size() < 2) {
-      continue;
-    }
-
-    std::reverse(dates.begin(), dates.end());
-    std::reverse(values.begin(), values.end());
-
-    auto* const s = add_series_to_chart(chart, dates, standard_deviation(values), table->name);
-
-    connect(s, &QLineSeries::hovered, this,
-            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
   }
 
   // portfolio
 
-  QVector<int> dates;
-  QVector<double> values;
-
-  for (int n = 0; n < portfolio->model->rowCount() && n < spinbox_months->value(); n++) {
-    auto qdt = QDateTime::fromString(portfolio->model->record(n).value("date").toString(), "MM/yyyy");
-
-    dates.append(qdt.toSecsSinceEpoch());
-    values.append(portfolio->model->record(n).value("net_return_perc").toDouble());
-  }
-
-  if (dates.size() < 2) {
-    return;
+  if (cache.portfolio.dates.size() >= 2) {
+    add_line_series(cache.portfolio.dates, cache.portfolio.volatility, cache.portfolio.name);
   }
-
-  std::reverse(dates.begin(), dates.end());
-  std::reverse(values.begin(), values.end());
-
-  auto* const s = add_series_to_chart(chart, dates, standard_deviation(values), portfolio->name);
-
-  connect(s, &QLineSeries::hovered, this,
-          [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
 }
 
 void CompareFunds::make_chart_accumulated_net_return_pie() {
   std::deque<QPair<QString, double>> deque;
 
   for (auto& table : tables) {
-    double value = table->model->record(0).value("accumulated_net_return").toDouble();
+    if (table->series.empty()) {
+      continue;
+    }
+
+    double value = table->series.accumulated_net_return.back();
 
     if (value > 0) {
       deque.emplace_back(table->name, value);
@@ -196,42 +144,10 @@ void CompareFunds::make_chart_accumulated_net_return() {
 
   add_axes_to_chart(chart, "%");
 
-  for (auto& table : tables) {
-    QVector<int> dates;
-    QVector<double> net_return;
-    QVector<double> accumulated_net_return;
-
-    for (int n = 0; n < table->model->rowCount() && dates.size() < spinbox_months->value(); n++) {
-      const auto qdt = QDateTime::fromString(table->model->record(n).value("date").toString(), "MM/yyyy");
-
-      dates.append(qdt.toSecsSinceEpoch());
-      net_return.append(table->model->record(n).value("net_return_perc").toDouble());
-    }
-
-    if (dates.size() < 2) {  // We need at least 2 points to show a line chart
-      continue;
+  for (auto& fund : analysis().funds) {
+    if (fund.dates.size() >= 2) {  // We need at least 2 points to show a line chart
+      add_line_series(fund.dates, fund.accumulated_net_return_perc, fund.name.toUpper());
     }
-
-    std::reverse(net_return.begin(), net_return.end());
-
-    for (auto& value : net_return) {
-      value = value * 0.01 + 1.0;
-    }
-
-    accumulated_net_return.resize(net_return.size());
-
-    std::partial_sum(net_return.begin(), net_return.end(), accumulated_net_return.begin(), std::multiplies<>());
-
-    for (auto& value : accumulated_net_return) {
-      value = (value - 1.0) * 100;
-    }
-
-    std::reverse(accumulated_net_return.begin(), accumulated_net_return.end());
-
-    auto* const s = add_series_to_chart(chart, dates, accumulated_net_return, table->name.toUpper());
-
-    connect(s, &QLineSeries::hovered, this,
-            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
   }
 }
 
@@ -240,74 +156,35 @@ void CompareFunds::make_chart_accumulated_net_return_second_derivative() {
 
   add_axes_to_chart(chart, "");
 
-  for (auto& table : tables) {
-    QVector<int> dates;
-    QVector<double> net_return;
-    QVector<double> accumulated_net_return;
-
-    for (int n = 0; n < table->model->rowCount() && dates.size() < spinbox_months->value(); n++) {
-      const auto qdt = QDateTime::fromString(table->model->record(n).value("date").toString(), "MM/yyyy");
-
-      dates.append(qdt.toSecsSinceEpoch());
-      net_return.append(table->model->record(n).value("net_return_perc").toDouble());
-    }
-
-    if (dates.size() < 3) {  // We need at least 3 points to calculate the second derivative
-      continue;
-    }
-
-    std::reverse(net_return.begin(), net_return.end());
-
-    for (auto& value : net_return) {
-      value = value * 0.01 + 1.0;
-    }
-
-    accumulated_net_return.resize(net_return.size());
+  const auto& cache = analysis();
 
-    std::partial_sum(net_return.begin(), net_return.end(), accumulated_net_return.begin(), std::multiplies<>());
+  // the second derivative is empty when there are less than 3 points
 
-    for (auto& value : accumulated_net_return) {
-      value = (value - 1.0) * 100;
+  for (auto& fund : cache.funds) {
+    if (!fund.second_derivative.empty()) {
+      add_line_series(fund.dates, fund.second_derivative, fund.name);
     }
-
-    std::reverse(dates.begin(), dates.end());
-    std::reverse(accumulated_net_return.begin(), accumulated_net_return.end());
-
-    auto* const s = add_series_to_chart(chart, dates, second_derivative(accumulated_net_return), table->name);
-
-    connect(s, &QLineSeries::hovered, this,
-            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
   }
 
   // portfolio
 
-  QVector<int> dates;
-  QVector<double> accumulated_net_return;
-
-  for (int n = 0; n < portfolio->model->rowCount() && dates.size() < spinbox_months->value(); n++) {
-    const auto qdt = QDateTime::fromString(portfolio->model->record(n).value("date").toString(), "MM/yyyy");
-
-    dates.append(qdt.toSecsSinceEpoch());
-    accumulated_net_return.append(portfolio->model->record(n).value("accumulated_net_return_perc").toDouble());
-  }
-
-  if (dates.size() < 3) {  // We need at least 3 points to calculate the second derivative
-    return;
+  if (!cache.portfolio.second_derivative.empty()) {
+    add_line_series(cache.portfolio.dates, cache.portfolio.second_derivative, cache.portfolio.name);
   }
+}
 
-  std::reverse(dates.begin(), dates.end());
-  std::reverse(accumulated_net_return.begin(), accumulated_net_return.end());
+void CompareFunds::make_chart_barseries(const QString& series_name, const QString& column_name) {
+  auto& cache = analysis();
 
-  auto* const s = add_series_to_chart(chart, dates, second_derivative(accumulated_net_return), portfolio->name);
+  if (!cache.has_bar_months) {
+    cache.bar_months = get_unique_months(tables, spinbox_months->value());
 
-  connect(s, &QLineSeries::hovered, this,
-          [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
-}
+    cache.has_bar_months = true;
+  }
 
-void CompareFunds::make_chart_barseries(const QString& series_name, const QString& column_name) {
-  const auto list_dates = get_unique_months_from_db(db, tables, spinbox_months->value());
+  const auto& months = cache.bar_months;
 
-  if (list_dates.empty()) {
+  if (months.empty()) {
     return;
   }
 
@@ -318,7 +195,7 @@ void CompareFunds::make_chart_barseries(const QString& series_name, const QStrin
   QStringList categories;
 
   std::tie(series, barsets, categories) =
-      add_tables_barseries_to_chart(chart, tables, list_dates, series_name, column_name);
+      add_tables_barseries_to_chart(chart, tables, months, series_name, column_name);
 
   connect(series, &QStackedBarSeries::hovered, this, [=](bool status, int index, QBarSet* barset) {
     if (status) {
@@ -354,6 +231,13 @@ void CompareFunds::make_chart_barseries(const QString& series_name, const QStrin
   });
 }
 
+void CompareFunds::add_line_series(const QVector<int>& dates, const QVector<double>& values, const QString& name) {
+  auto* const s = add_series_to_chart(chart, dates, values, name);
+
+  connect(s, &QLineSeries::hovered, this,
+          [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
+}
+
 void CompareFunds::make_pie(std::deque<QPair<QString, double>>& deque) {
   const double pie_chart_size = 0.6;
 
@@ -407,12 +291,83 @@ void CompareFunds::process(const QVector<TableFund const*>& tables, TablePortfol
   this->tables = tables;
   this->portfolio = portfolio;
 
+  // the tables were calculated again
+
+  analysis_cache.reset();
+
   process_tables();
 }
 
+auto CompareFunds::analysis() -> Analysis& {
+  QVector<QByteArray> revision;
+
+  for (auto& table : tables) {
+    revision.append(table->results_hash());
+  }
+
+  if (revision != analysis_revision) {
+    analysis_cache.reset();
+
+    analysis_revision = revision;
+  }
+
+  const int last_n_months = spinbox_months->value();
+
+  if (analysis_cache.has_value() && analysis_months == last_n_months) {
+    return *analysis_cache;
+  }
+
+  Analysis output;
+
+  for (auto& table : tables) {
+    output.funds.append(analyze(table->series, table->name, last_n_months));
+  }
+
+  output.portfolio = analyze(portfolio->series, portfolio->name, last_n_months);
+
+  // The portfolio second derivative uses its saved accumulated return instead of the one compounded inside the window
+
+  const int first = portfolio->series.window_start(last_n_months);
+
+  if (output.portfolio.dates.size() >= 3) {
+    output.portfolio.second_derivative = second_derivative(portfolio->series.accumulated_net_return_perc.mid(first));
+  }
+
+  analysis_cache = std::move(output);
+  analysis_months = last_n_months;
+
+  return *analysis_cache;
+}
+
+auto CompareFunds::analyze(const FundSeries& series, const QString& name, const int& last_n_months)
+    -> SeriesAnalysis {
+  SeriesAnalysis output;
+
+  const int first = series.window_start(last_n_months);
+
+  output.name = name;
+  output.dates = series.dates.mid(first);
+  output.net_return_perc = series.net_return_perc.mid(first);
+  output.volatility = standard_deviation(output.net_return_perc);
+
+  output.accumulated_net_return_perc = output.net_return_perc;
+
+  compound_returns(output.accumulated_net_return_perc);
+
+  if (output.dates.size() >= 3) {  // We need at least 3 points to calculate the second derivative
+    output.second_derivative = second_derivative(output.accumulated_net_return_perc);
+  }
+
+  return output;
+}
+
 void CompareFunds::process_tables() {
   clear_chart(chart);
 
+  if (portfolio == nullptr) {
+    return;
+  }
+
   if (radio_net_balance_pie->isChecked()) {
     make_chart_net_balance_pie();
   } else if (radio_net_balance->isChecked()) {
@@ -3,6 +3,7 @@
 
 #include <QSqlDatabase>
 #include <deque>
+#include <optional>
 #include "callout.hpp"
 #include "table_fund.hpp"
 #include "table_portfolio.hpp"
@@ -26,6 +27,46 @@ class CompareFunds : public QWidget, protected Ui::CompareFunds {
 
   TablePortfolio const* portfolio = nullptr;
 
+  // Values shown by the line charts for the months inside the time window
+
+  struct SeriesAnalysis {
+    QString name;
+
+    QVector<int> dates;
+    QVector<double> net_return_perc;
+    QVector<double> volatility;
+    QVector<double> accumulated_net_return_perc;  // compounded from the first month of the window
+    QVector<double> second_derivative;
+  };
+
+  struct Analysis {
+    QVector<SeriesAnalysis> funds;
+
+    SeriesAnalysis portfolio;
+
+    // months used by the bar charts. They are built from the table series when a bar chart is first shown
+
+    QVector<int> bar_months;
+
+    bool has_bar_months = false;
+  };
+
+  /*
+    Analysis of the time window being shown. Switching between charts only draws the chart again. It is replaced
+    when the window changes and cleared when the tables are processed again or when one of the investments has
+    different results. See TableFund::results_hash()
+  */
+
+  std::optional<Analysis> analysis_cache;
+
+  int analysis_months = 0;
+
+  QVector<QByteArray> analysis_revision;
+
+  auto analysis() -> Analysis&;
+
+  static auto analyze(const FundSeries& series, const QString& name, const int& last_n_months) -> SeriesAnalysis;
+
   void process_tables();
 
   void make_chart_net_balance_pie();
@@ -37,6 +78,8 @@ class CompareFunds : public QWidget, protected Ui::CompareFunds {
   void make_chart_accumulated_net_return_second_derivative();
   void make_chart_barseries(const QString& series_name, const QString& column_name);
 
+  void add_line_series(const QVector<int>& dates, const QVector<double>& values, const QString& name);
+
   void make_pie(std::deque<QPair<QString, double>>& deque);
 
   void on_chart_selection(const bool& state);
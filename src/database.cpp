@@ -0,0 +1,235 @@
+#include "database.hpp"
+#include <QDebug>
+#include <QHash>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QStringList>
+
+namespace {
+
+/*
+  Prepared statements of one connection. It is a child of the connection driver. It is destroyed together with the
+  connection, after the driver has finalized the statements, and it lives in the thread that owns the connection.
+*/
+
+class StatementCache : public QObject {
+ public:
+  using QObject::QObject;
+
+  QHash<QString, QSqlQuery> statements;
+};
+
+const QString statement_cache_name = "statement_cache";
+
+auto statement_cache(const QSqlDatabase& db) -> StatementCache* {
+  auto* driver = db.driver();
+
+  if (driver == nullptr) {
+    return nullptr;
+  }
+
+  auto* cache = driver->findChild<QObject*>(statement_cache_name, Qt::FindDirectChildrenOnly);
+
+  if (cache == nullptr) {
+    cache = new StatementCache(driver);
+
+    cache->setObjectName(statement_cache_name);
+  }
+
+  return static_cast<StatementCache*>(cache);
+}
+
+}  // namespace
+
+auto open_database(const QString& path, const QString& connection_name) -> QSqlDatabase {
+  auto db = QSqlDatabase::addDatabase("QSQLITE", connection_name);
+
+  db.setDatabaseName(path);
+
+  if (!db.open()) {
+    return db;
+  }
+
+  for (const auto& pragma : {"pragma journal_mode = wal", "pragma synchronous = normal", "pragma temp_store = memory",
+                             "pragma mmap_size = 268435456", "pragma cache_size = -65536"}) {
+    auto query = QSqlQuery(db);
+
+    if (!query.exec(pragma)) {
+      qDebug() << query.lastError().text().toUtf8();
+    }
+  }
+
+  return db;
+}
+
+auto cached_query(const QSqlDatabase& db, const QString& statement) -> QSqlQuery& {
+  auto& statements = statement_cache(db)->statements;
+
+  auto it = statements.find(statement);
+
+  if (it == statements.end()) {
+    auto query = QSqlQuery(db);
+
+    if (!query.prepare(statement)) {
+      qDebug() << query.lastError().text().toUtf8();
+    }
+
+    it = statements.insert(statement, query);
+  } else {
+    it->finish();
+  }
+
+  return it.value();
+}
+
+void clear_statement_cache(const QSqlDatabase& db) {
+  auto* cache = statement_cache(db);
+
+  if (cache != nullptr) {
+    cache->statements.clear();
+  }
+}
+
+auto read_fund_series(const QSqlDatabase& db, const QString& table_name) -> std::tuple<FundSeries, QVector<int>> {
+  FundSeries series;
+  QVector<int> ids;
+
+  QString columns;
+
+  for (const auto& column : FundSeries::columns) {
+    columns += QString(",") + column.first;
+  }
+
+  auto& query = cached_query(db, "select id,date" + columns + " from " + table_name + " order by date,id");
+
+  if (!query.exec()) {
+    qDebug() << query.lastError().text().toUtf8();
+
+    return {series, ids};
+  }
+
+  QVector<QVector<double>> values(FundSeries::columns.size());
+
+  while (query.next()) {
+    const int date = query.value(1).toInt();
+
+    ids.append(query.value(0).toInt());
+
+    series.dates.append(date);
+    series.months.append(month_key(date));
+
+    for (int n = 0; n < values.size(); n++) {
+      values[n].append(query.value(n + 2).toDouble());
+    }
+  }
+
+  query.finish();
+
+  for (size_t n = 0; n < FundSeries::columns.size(); n++) {
+    series.*FundSeries::columns[n].second = values[static_cast<int>(n)];
+  }
+
+  series.accumulated_gross_return.resize(series.size());
+
+  return {series, ids};
+}
+
+auto write_derived_columns(const QSqlDatabase& db,
+                           const QString& table_name,
+                           const FundSeries& series,
+                           const QVector<int>& ids) -> bool {
+  // the first 4 columns are the user input
+
+  constexpr int first_derived = 4;
+
+  QStringList assignments;
+
+  for (size_t n = first_derived; n < FundSeries::columns.size(); n++) {
+    assignments.append(QString(FundSeries::columns[n].first) + "=?");
+  }
+
+  auto database = db;
+
+  database.transaction();
+
+  auto& query = cached_query(db, "update " + table_name + " set " + assignments.join(",") + " where id=?");
+
+  bool success = true;
+
+  for (int row = 0; row < ids.size() && success; row++) {
+    int position = 0;
+
+    for (size_t n = first_derived; n < FundSeries::columns.size(); n++) {
+      query.bindValue(position++, (series.*FundSeries::columns[n].second)[row]);
+    }
+
+    query.bindValue(position, ids[row]);
+
+    success = query.exec();
+  }
+
+  if (success) {
+    success = database.commit();
+  } else {
+    qDebug() << query.lastError().text().toUtf8();
+
+    database.rollback();
+  }
+
+  return success;
+}
+
+auto write_fund_series(const QSqlDatabase& db, const QString& table_name, const FundSeries& series) -> bool {
+  QString columns;
+  QString placeholders;
+
+  for (const auto& column : FundSeries::columns) {
+    columns += QString(",") + column.first;
+    placeholders += ",?";
+  }
+
+  auto database = db;
+
+  // The whole rebuild is done in a single transaction so SQLite syncs the file only once
+
+  if (!database.transaction()) {
+    qDebug() << database.lastError().text().toUtf8();
+  }
+
+  auto& delete_query = cached_query(db, "delete from " + table_name);
+
+  bool success = delete_query.exec();
+
+  if (!success) {
+    qDebug() << delete_query.lastError().text().toUtf8();
+  }
+
+  auto& insert_query =
+      cached_query(db, "insert or replace into " + table_name + " (date" + columns + ") values (?" + placeholders + ")");
+
+  for (int row = 0; row < series.size() && success; row++) {
+    insert_query.bindValue(0, series.dates[row]);
+
+    for (size_t n = 0; n < FundSeries::columns.size(); n++) {
+      insert_query.bindValue(static_cast<int>(n) + 1, (series.*FundSeries::columns[n].second)[row]);
+    }
+
+    success = insert_query.exec();
+
+    if (!success) {
+      qDebug() << insert_query.lastError().text().toUtf8();
+    }
+  }
+
+  if (success) {
+    success = database.commit();
+
+    if (!success) {
+      qDebug() << database.lastError().text().toUtf8();
+    }
+  } else {
+    database.rollback();
+  }
+
+  return success;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef DATABASE_HPP
+#define DATABASE_HPP
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVector>
+#include <tuple>
+#include "fund_series.hpp"
+
+/*
+  Opens the sqlite file with the settings used by the whole program. The journal is kept in WAL mode with
+  synchronous=NORMAL so a commit does not have to wait for the rollback journal fsyncs. Reads go through a memory
+  mapping and a larger page cache.
+*/
+
+auto open_database(const QString& path, const QString& connection_name = QSqlDatabase::defaultConnection)
+    -> QSqlDatabase;
+
+/*
+  Prepared statements cached by their sql text. Each connection has its own cache. It is released when the connection
+  is removed and, like the connection, it can only be used by the thread that opened it. The returned query is already
+  prepared and its last execution was finished. Only the values have to be bound. Statements that use a table that was
+  renamed or removed must be released with clear_statement_cache().
+*/
+
+auto cached_query(const QSqlDatabase& db, const QString& statement) -> QSqlQuery&;
+
+void clear_statement_cache(const QSqlDatabase& db);
+
+// Rows of an investment or portfolio table in ascending date order and the id of each one of them
+
+auto read_fund_series(const QSqlDatabase& db, const QString& table_name) -> std::tuple<FundSeries, QVector<int>>;
+
+// writes the derived columns back to the rows with the given ids. Everything is done in one transaction
+
+auto write_derived_columns(const QSqlDatabase& db,
+                           const QString& table_name,
+                           const FundSeries& series,
+                           const QVector<int>& ids) -> bool;
+
+// replaces all the rows of an investment or portfolio table in one transaction
+
+auto write_fund_series(const QSqlDatabase& db, const QString& table_name, const FundSeries& series) -> bool;
+
+#endif
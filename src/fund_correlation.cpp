@@ -2,6 +2,7 @@
 #include "chart_funcs.hpp"
 #include "effects.hpp"
 #include "math.hpp"
+#include "series_alignment.hpp"
 
 FundCorrelation::FundCorrelation(const QSqlDatabase& database, QWidget* parent)
     : db(database), chart(new QChart()), callout(new Callout(chart)) {
@@ -14,6 +15,8 @@ FundCorrelation::FundCorrelation(const QSqlDatabase& database, QWidget* parent)
   frame_chart->setGraphicsEffect(card_shadow());
   frame_fund_selection->setGraphicsEffect(card_shadow());
   frame_time_window->setGraphicsEffect(card_shadow());
+  frame_mode->setGraphicsEffect(card_shadow());
+  frame_matrix_window->setGraphicsEffect(card_shadow());
   button_reset_zoom->setGraphicsEffect(button_shadow());
 
   // chart settings
@@ -26,10 +29,22 @@ FundCorrelation::FundCorrelation(const QSqlDatabase& database, QWidget* parent)
   chart_view->setRenderHint(QPainter::Antialiasing);
   chart_view->setRubberBand(QChartView::RectangleRubberBand);
 
+  // correlation matrix settings
+
+  table_matrix->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  table_matrix->verticalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+
   // signals
 
   connect(button_reset_zoom, &QPushButton::clicked, this, [&]() { chart->zoomReset(); });
   connect(spinbox_months, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) { process_tables(); });
+
+  connect(radio_single, &QRadioButton::toggled, this, &FundCorrelation::on_mode_selection);
+  connect(radio_matrix, &QRadioButton::toggled, this, &FundCorrelation::on_mode_selection);
+  connect(radio_trailing, &QRadioButton::toggled, this, &FundCorrelation::on_mode_selection);
+  connect(radio_expanding, &QRadioButton::toggled, this, &FundCorrelation::on_mode_selection);
+
+  on_mode_selection(true);
 }
 
 void FundCorrelation::process(const QVector<TableFund const*>& tables, TablePortfolio const* portfolio) {
@@ -61,145 +76,148 @@ void FundCorrelation::process(const QVector<TableFund const*>& tables, TablePort
   process_tables();
 }
 
-void FundCorrelation::process_fund_tables(const QVector<int>& dates) {
-  QVector<double> values(dates.size(), 0.0);
-
-  for (auto& table : tables) {
-    if (table->name == combo_fund->currentText()) {
-      int count = 0;
+void FundCorrelation::process_tables() {
+  if (portfolio == nullptr) {
+    return;
+  }
 
-      for (auto& date : dates) {
-        for (int n = 0; n < table->model->rowCount(); n++) {
-          QString tdate = table->model->record(n).value("date").toString();
+  if (radio_matrix->isChecked()) {
+    make_matrix();
+  } else {
+    make_chart();
+  }
+}
 
-          auto qdt = QDateTime::fromString(tdate, "MM/yyyy");
+void FundCorrelation::make_chart() {
+  clear_chart(chart);
 
-          if (qdt.toSecsSinceEpoch() == date) {
-            values[count] = table->model->record(n).value("net_return_perc").toDouble();
-          }
-        }
+  // The combo box lists the funds followed by the portfolio. The aligned matrix columns follow the same order
 
-        count++;
-      }
+  QVector<FundSeries const*> series;
 
-      break;
-    }
+  for (auto& table : tables) {
+    series.append(&table->series);
   }
 
-  for (auto& table : tables) {
-    if (table->name != combo_fund->currentText()) {
-      QVector<double> tvalues(dates.size(), 0.0);
-      int count = 0;
+  series.append(&portfolio->series);
 
-      for (auto& date : dates) {
-        for (int n = 0; n < table->model->rowCount(); n++) {
-          QString tdate = table->model->record(n).value("date").toString();
+  const auto aligned = align_series(series, &FundSeries::net_return_perc, spinbox_months->value());
 
-          auto qdt = QDateTime::fromString(tdate, "MM/yyyy");
+  if (aligned.months.empty()) {
+    return;
+  }
 
-          if (qdt.toSecsSinceEpoch() == date) {
-            tvalues[count] = table->model->record(n).value("net_return_perc").toDouble();
-          }
-        }
+  chart->setTitle("Correlation Coefficient");
+
+  add_axes_to_chart(chart, "");
 
-        count++;
-      }
+  const auto dates = months_to_dates(aligned.months);
 
-      auto s = add_series_to_chart(chart, dates, correlation_coefficient(values, tvalues), table->name);
+  const int selected = combo_fund->currentIndex();
 
-      connect(s, &QLineSeries::hovered, this,
-              [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
+  for (int m = 0; m < series.size(); m++) {
+    if (m == selected) {
+      continue;
     }
-  }
 
-  // portfolio
+    const auto& name = (m < tables.size()) ? tables[m]->name : portfolio->name;
 
-  QVector<double> portfolio_values(dates.size(), 0.0);
-  int count = 0;
+    auto s = add_series_to_chart(chart, dates, correlation(aligned, selected, m), name);
 
-  for (auto& date : dates) {
-    for (int n = 0; n < portfolio->model->rowCount(); n++) {
-      QString tdate = portfolio->model->record(n).value("date").toString();
+    connect(s, &QLineSeries::hovered, this,
+            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
+  }
 
-      auto qdt = QDateTime::fromString(tdate, "MM/yyyy");
+  chart->axes(Qt::Vertical)[0]->setRange(-1.0, 1.0);
+}
 
-      if (qdt.toSecsSinceEpoch() == date) {
-        portfolio_values[count] = portfolio->model->record(n).value("net_return_perc").toDouble();
-      }
-    }
+void FundCorrelation::make_matrix() {
+  QVector<FundSeries const*> series;
+  QStringList names;
 
-    count++;
+  for (auto& table : tables) {
+    series.append(&table->series);
+    names.append(table->name);
   }
 
-  auto s = add_series_to_chart(chart, dates, correlation_coefficient(values, portfolio_values), portfolio->name);
+  series.append(&portfolio->series);
+  names.append(portfolio->name);
 
-  connect(s, &QLineSeries::hovered, this,
-          [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
-}
+  // the expanding window uses the whole history
+
+  const int last_n_months = radio_trailing->isChecked() ? spinbox_months->value() : 0;
+
+  const auto aligned = align_series(series, &FundSeries::net_return_perc, last_n_months);
+
+  table_matrix->clear();
+  table_matrix->setRowCount(names.size());
+  table_matrix->setColumnCount(names.size());
+  table_matrix->setHorizontalHeaderLabels(names);
+  table_matrix->setVerticalHeaderLabels(names);
+
+  if (aligned.months.size() < 2) {
+    return;
+  }
 
-void FundCorrelation::process_portfolio_table(const QVector<int>& dates) {
-  QVector<double> values(dates.size(), 0.0);
-  int count = 0;
+  const Eigen::MatrixXd matrix = correlation_matrix(aligned.values, aligned.mask);
 
-  for (auto& date : dates) {
-    for (int n = 0; n < portfolio->model->rowCount(); n++) {
-      QString tdate = portfolio->model->record(n).value("date").toString();
+  for (int n = 0; n < matrix.rows(); n++) {
+    for (int m = 0; m < matrix.cols(); m++) {
+      auto* const item = new QTableWidgetItem(QString::number(matrix(n, m), 'f', 2));
 
-      auto qdt = QDateTime::fromString(tdate, "MM/yyyy");
+      item->setTextAlignment(Qt::AlignCenter);
+      item->setBackground(heatmap_color(matrix(n, m)));
+      item->setToolTip(QString("%1\n%2\nCorrelation: %3")
+                           .arg(names[n], names[m], QString::number(matrix(n, m), 'f', 2)));
 
-      if (qdt.toSecsSinceEpoch() == date) {
-        values[count] = portfolio->model->record(n).value("net_return_perc").toDouble();
-      }
+      table_matrix->setItem(n, m, item);
     }
+  }
+}
 
-    count++;
+void FundCorrelation::on_mode_selection(const bool& state) {
+  if (!state) {
+    return;
   }
 
-  for (auto& table : tables) {
-    QVector<double> tvalues(dates.size(), 0.0);
-    int count = 0;
+  const bool matrix = radio_matrix->isChecked();
 
-    for (auto& date : dates) {
-      for (int n = 0; n < table->model->rowCount(); n++) {
-        QString tdate = table->model->record(n).value("date").toString();
+  stackedwidget->setCurrentIndex(matrix ? 1 : 0);
 
-        auto qdt = QDateTime::fromString(tdate, "MM/yyyy");
+  combo_fund->setDisabled(matrix);
+  button_reset_zoom->setDisabled(matrix);
+  frame_matrix_window->setDisabled(!matrix);
+  spinbox_months->setDisabled(matrix && radio_expanding->isChecked());
 
-        if (qdt.toSecsSinceEpoch() == date) {
-          tvalues[count] = table->model->record(n).value("net_return_perc").toDouble();
-        }
-      }
+  process_tables();
+}
 
-      count++;
-    }
+auto FundCorrelation::heatmap_color(const double& value) -> QColor {
+  // white for zero going to red for +1 and to blue for -1
 
-    auto s = add_series_to_chart(chart, dates, correlation_coefficient(values, tvalues), table->name);
+  const double v = std::clamp(value, -1.0, 1.0);
 
-    connect(s, &QLineSeries::hovered, this,
-            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
-  }
-}
+  const int fade = static_cast<int>(255 * (1.0 - std::fabs(v)));
 
-void FundCorrelation::process_tables() {
-  clear_chart(chart);
+  return (v > 0) ? QColor(255, fade, fade) : QColor(fade, fade, 255);
+}
 
-  const auto dates = get_unique_months_from_db(db, tables, spinbox_months->value());
+auto FundCorrelation::correlation(const AlignedSeries& aligned, const int& a, const int& b) -> QVector<double> {
+  QVector<double> output(aligned.months.size(), 0.0);
 
-  if (dates.empty()) {
-    return;
-  }
+  RunningCovariance<double> covariance;
 
-  chart->setTitle("Correlation Coefficient");
+  // months missing in one of the series are skipped and the last value is kept
 
-  add_axes_to_chart(chart, "");
+  for (int n = 0; n < output.size(); n++) {
+    if (aligned.mask(n, a) && aligned.mask(n, b)) {
+      covariance.add(aligned.values(n, a), aligned.values(n, b));
+    }
 
-  if (combo_fund->currentText() != portfolio->name) {
-    process_fund_tables(dates);
-  } else {
-    process_portfolio_table(dates);
+    output[n] = covariance.correlation();
   }
 
-  chart->axes(Qt::Vertical)[0]->setRange(-1.0, 1.0);
+  return output;
 }
 
 void FundCorrelation::on_chart_mouse_hover(const QPointF& point, bool state, Callout* c, const QString& name) {
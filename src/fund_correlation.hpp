@@ -3,6 +3,7 @@
 
 #include <QSqlDatabase>
 #include "callout.hpp"
+#include "series_alignment.hpp"
 #include "table_fund.hpp"
 #include "table_portfolio.hpp"
 #include "ui_fund_correlation.h"
@@ -26,8 +27,14 @@ class FundCorrelation : public QWidget, protected Ui::FundCorrelation {
   TablePortfolio const* portfolio = nullptr;
 
   void process_tables();
-  void process_fund_tables(const QVector<int>& dates);
-  void process_portfolio_table(const QVector<int>& dates);
+  void make_chart();
+  void make_matrix();
+
+  void on_mode_selection(const bool& state);
+
+  static auto heatmap_color(const double& value) -> QColor;
+
+  static auto correlation(const AlignedSeries& aligned, const int& a, const int& b) -> QVector<double>;
 
   static void on_chart_mouse_hover(const QPointF& point, bool state, Callout* c, const QString& name);
 };
@@ -1,8 +1,8 @@
 #include "fund_pca.hpp"
-#include <Eigen/Core>
-#include <Eigen/Eigenvalues>
 #include "chart_funcs.hpp"
 #include "effects.hpp"
+#include "math.hpp"
+#include "series_alignment.hpp"
 
 FundPCA::FundPCA(const QSqlDatabase& database, QWidget* parent)
     : db(database), chart(new QChart()), callout(new Callout(chart)) {
@@ -15,6 +15,7 @@ FundPCA::FundPCA(const QSqlDatabase& database, QWidget* parent)
   frame_chart->setGraphicsEffect(card_shadow());
   frame_time_window->setGraphicsEffect(card_shadow());
   frame_explained_variance->setGraphicsEffect(card_shadow());
+  frame_mode->setGraphicsEffect(card_shadow());
   button_reset_zoom->setGraphicsEffect(button_shadow());
 
   // chart settings
@@ -31,6 +32,18 @@ FundPCA::FundPCA(const QSqlDatabase& database, QWidget* parent)
 
   connect(button_reset_zoom, &QPushButton::clicked, this, [&]() { chart->zoomReset(); });
   connect(spinbox_months, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) { process_tables(); });
+
+  connect(radio_snapshot, &QRadioButton::toggled, this, [&](bool state) {
+    if (state) {
+      process_tables();
+    }
+  });
+
+  connect(radio_rolling, &QRadioButton::toggled, this, [&](bool state) {
+    if (state) {
+      process_tables();
+    }
+  });
 }
 
 void FundPCA::process(const QVector<TableFund const*>& tables) {
@@ -42,74 +55,50 @@ void FundPCA::process(const QVector<TableFund const*>& tables) {
 void FundPCA::process_tables() {
   clear_chart(chart);
 
-  chart->setTitle("Net Return Pricipal Component Analysis");
+  // in the rolling mode the components of each window are not the same directions, so they are named as factors
+
+  const QString prefix = radio_rolling->isChecked() ? "F" : "PC";
+
+  label_explained_variance->setText(radio_rolling->isChecked() ? "Common Factors" : "Explained Variance");
+  label_pc1->setText(prefix + "1: 0%");
+  label_pc2->setText(prefix + "2: 0%");
 
   if (tables.size() < 2) {
     return;
   }
 
-  Eigen::MatrixXd data = Eigen::MatrixXd::Zero(tables.size(), spinbox_months->value());
-
-  for (int k = 0; k < tables.size(); k++) {
-    for (int n = 0; n < tables[k]->model->rowCount() && n < spinbox_months->value(); n++) {
-      data(k, n) = tables[k]->model->record(n).value("net_return_perc").toDouble();
-    }
+  if (radio_rolling->isChecked()) {
+    make_rolling_chart();
+  } else {
+    make_scatter_chart();
   }
+}
 
-  // Standardizing the data https://en.wikipedia.org/wiki/Feature_scaling#Standardization_(Z-score_Normalization)
-
-  data = data.rowwise() - data.colwise().mean();
+void FundPCA::make_scatter_chart() {
+  chart->setTitle("Net Return Pricipal Component Analysis");
 
-  Eigen::ArrayXd stddev = (data.array() * data.array()).colwise().sum().sqrt() / std::sqrt(data.rows() - 1);
+  // the investments are matched by month. Months missing in some of them do not shift the others
 
-  for (int n = 0; n < data.cols(); n++) {
-    double std = stddev(n);
-    const double tol = 0.0001;
+  QVector<FundSeries const*> series;
 
-    for (int m = 0; m < data.rows(); m++) {
-      if (std > tol) {
-        data(m, n) /= std;
-      }
-    }
+  for (auto& table : tables) {
+    series.append(&table->series);
   }
 
-  // https://en.wikipedia.org/wiki/Sample_mean_and_covariance#Sample_covariance
+  const auto aligned = align_series(series, &FundSeries::net_return_perc, spinbox_months->value());
 
-  Eigen::MatrixXd covariance =
-      (data.rowwise() - data.colwise().mean()).transpose() * (data.rowwise() - data.colwise().mean());
-
-  if (data.rows() > 1) {
-    covariance /= (data.rows() - 1);
+  if (aligned.months.size() < 2) {
+    return;
   }
 
-  // Finding eigenvalues and eigenvectors. We use SelfAdjointEigenSolver because the covariance matrix is symmetric.
+  // only the first two components are shown
 
-  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver;
+  const auto components = principal_components(aligned.values, aligned.mask, 2);
 
-  solver.compute(covariance);
+  label_pc1->setText(QString("PC1: %1%").arg(QString::number(components.explained_variance(0), 'f', 1)));
+  label_pc2->setText(QString("PC2: %1%").arg(QString::number(components.explained_variance(1), 'f', 1)));
 
-  Eigen::VectorXd eigenvalues = solver.eigenvalues();
-  Eigen::MatrixXd eigenvectors = solver.eigenvectors();
-
-  // Calculating the explained variance
-
-  double eigenvalues_sum = eigenvalues.sum();
-  Eigen::VectorXd percentage = 100 * eigenvalues / eigenvalues_sum;
-
-  double pc1_explained_variance = percentage[percentage.size() - 1];
-  double pc2_explained_variance = percentage[percentage.size() - 2];
-
-  label_pc1->setText(QString("PC1: %1%").arg(QString::number(pc1_explained_variance, 'f', 1)));
-  label_pc2->setText(QString("PC2: %1%").arg(QString::number(pc2_explained_variance, 'f', 1)));
-
-  // Projecting the data to the new space
-
-  Eigen::MatrixXd projection_matrix(eigenvectors.rows(), 2);
-
-  projection_matrix.col(0) = eigenvectors.col(eigenvectors.cols() - 1);
-  projection_matrix.col(1) = eigenvectors.col(eigenvectors.cols() - 2);
-
-  Eigen::MatrixXd pdata = data * projection_matrix;
+  const Eigen::MatrixXd pdata = components.scores;
 
   // Showing the data in the chart
 
@@ -196,3 +185,70 @@ void FundPCA::process_tables() {
   chart->axes(Qt::Horizontal)[0]->setRange(xmin - 0.05 * fabs(xmin), xmax + 0.05 * fabs(xmax));
   chart->axes(Qt::Vertical)[0]->setRange(ymin - 0.05 * fabs(ymin), ymax + 0.05 * fabs(ymax));
 }
+
+void FundPCA::make_rolling_chart() {
+  chart->setTitle("Net Return Common Factors (Rolling Window)");
+
+  QVector<FundSeries const*> series;
+
+  for (auto& table : tables) {
+    series.append(&table->series);
+  }
+
+  const auto aligned = align_series(series, &FundSeries::net_return_perc, 0);
+
+  const int window = spinbox_months->value();
+
+  if (aligned.months.size() < 2) {
+    return;
+  }
+
+  // Here the months are the observations and the investments the variables. Each point is the fraction of the
+  // variance of the investments returns in the last "window" months that is explained by each component
+
+  const Eigen::MatrixXd explained_variance = rolling_explained_variance(aligned.values, aligned.mask, window, 2);
+
+  // the first months do not have a full window yet
+
+  const int first = std::max(1, std::min(window, aligned.months.size()) - 1);
+
+  const auto dates = months_to_dates(aligned.months.mid(first));
+
+  add_axes_to_chart(chart, "%");
+
+  for (int k = 0; k < 2; k++) {
+    QVector<double> values;
+
+    for (int n = first; n < explained_variance.rows(); n++) {
+      values.append(explained_variance(n, k));
+    }
+
+    auto s = add_series_to_chart(chart, dates, values, QString("F%1").arg(k + 1));
+
+    connect(s, &QLineSeries::hovered, this, [=](const QPointF& point, bool state) {
+      if (state) {
+        auto qdt = QDateTime();
+
+        qdt.setMSecsSinceEpoch(point.x());
+
+        callout->setText(QString("%1\nDate: %2\nExplained Variance: %3%")
+                             .arg(s->name(), qdt.toString("MM/yyyy"), QString::number(point.y(), 'f', 1)));
+
+        callout->setAnchor(point);
+
+        callout->setZValue(11);
+
+        callout->updateGeometry();
+
+        callout->show();
+      } else {
+        callout->hide();
+      }
+    });
+  }
+
+  const auto last = explained_variance.rows() - 1;
+
+  label_pc1->setText(QString("F1: %1%").arg(QString::number(explained_variance(last, 0), 'f', 1)));
+  label_pc2->setText(QString("F2: %1%").arg(QString::number(explained_variance(last, 1), 'f', 1)));
+}
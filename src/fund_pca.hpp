@@ -23,6 +23,14 @@ class FundPCA : public QWidget, protected Ui::FundPCA {
   QVector<TableFund const*> tables;
 
   void process_tables();
+
+  // first two components of the investments over the selected time window
+
+  void make_scatter_chart();
+
+  // explained variance of the first two components over a window that slides through the whole history
+
+  void make_rolling_chart();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "fund_series.hpp"
+#include <QDateTime>
+#include <algorithm>
+
+const std::array<std::pair<const char*, FundSeries::Column>, 14> FundSeries::columns = {
+    {{"deposit", &FundSeries::deposit},
+     {"withdrawal", &FundSeries::withdrawal},
+     {"starting_balance", &FundSeries::starting_balance},
+     {"ending_balance", &FundSeries::ending_balance},
+     {"accumulated_deposit", &FundSeries::accumulated_deposit},
+     {"accumulated_withdrawal", &FundSeries::accumulated_withdrawal},
+     {"net_deposit", &FundSeries::net_deposit},
+     {"net_balance", &FundSeries::net_balance},
+     {"net_return", &FundSeries::net_return},
+     {"net_return_perc", &FundSeries::net_return_perc},
+     {"accumulated_net_return", &FundSeries::accumulated_net_return},
+     {"accumulated_net_return_perc", &FundSeries::accumulated_net_return_perc},
+     {"real_return_perc", &FundSeries::real_return_perc},
+     {"accumulated_real_return_perc", &FundSeries::accumulated_real_return_perc}}};
+
+auto FundSeries::column(const QString& name) -> Column {
+  for (const auto& [column_name, column] : columns) {
+    if (name == column_name) {
+      return column;
+    }
+  }
+
+  return nullptr;
+}
+
+void FundSeries::resize(const int& size) {
+  months.resize(size);
+  dates.resize(size);
+  accumulated_gross_return.resize(size);
+
+  for (const auto& c : columns) {
+    (this->*c.second).resize(size);
+  }
+}
+
+auto FundSeries::find(const int& month) const -> int {
+  const auto it = std::lower_bound(months.begin(), months.end(), month);
+
+  if (it == months.end() || *it != month) {
+    return -1;
+  }
+
+  return static_cast<int>(it - months.begin());
+}
+
+auto FundSeries::window_start(const int& last_n_months) const -> int {
+  return std::max(0, size() - last_n_months);
+}
+
+auto month_key(const int& epoch) -> int {
+  const auto date = QDateTime::fromSecsSinceEpoch(epoch).date();
+
+  return date.year() * 12 + date.month() - 1;
+}
+
+auto month_key_to_epoch(const int& month) -> int {
+  return static_cast<int>(QDateTime(QDate(month / 12, month % 12 + 1, 1), QTime(0, 0)).toSecsSinceEpoch());
+}
+
+auto month_key_to_string(const int& month) -> QString {
+  return QString("%1/%2").arg(month % 12 + 1, 2, 10, QChar('0')).arg(month / 12);
+}
@@ -0,0 +1,72 @@
+#ifndef FUND_SERIES_HPP
+#define FUND_SERIES_HPP
+
+#include <QString>
+#include <QVector>
+#include <array>
+#include <utility>
+
+/*
+  Columnar snapshot of an investment or portfolio table. Rows are stored in chronological order (the oldest month is
+  at index 0) so that the analysis code can read the columns directly without going through QSqlRecord.
+*/
+
+struct FundSeries {
+  using Column = QVector<double> FundSeries::*;
+
+  QVector<int> months;  // see month_key()
+  QVector<int> dates;   // seconds since epoch as stored in the database
+
+  QVector<double> deposit;
+  QVector<double> withdrawal;
+  QVector<double> starting_balance;
+  QVector<double> ending_balance;
+  QVector<double> accumulated_deposit;
+  QVector<double> accumulated_withdrawal;
+  QVector<double> net_deposit;
+  QVector<double> net_balance;
+  QVector<double> net_return;
+  QVector<double> net_return_perc;
+  QVector<double> accumulated_net_return;
+  QVector<double> accumulated_net_return_perc;
+  QVector<double> real_return_perc;
+  QVector<double> accumulated_real_return_perc;
+
+  // not stored in the database. Needed to continue the net balance calculation from an arbitrary row
+
+  QVector<double> accumulated_gross_return;
+
+  // value columns in the same order they have in the database tables
+
+  static const std::array<std::pair<const char*, Column>, 14> columns;
+
+  [[nodiscard]] static auto column(const QString& name) -> Column;
+
+  [[nodiscard]] auto size() const -> int { return months.size(); }
+
+  [[nodiscard]] auto empty() const -> bool { return months.empty(); }
+
+  void resize(const int& size);
+
+  // index of the row with the given month key or -1 if the month is not in the series
+
+  [[nodiscard]] auto find(const int& month) const -> int;
+
+  // index of the first row of a window with the last n months
+
+  [[nodiscard]] auto window_start(const int& last_n_months) const -> int;
+};
+
+// months since year 0. Used to match rows from different tables without comparing date strings
+
+auto month_key(const int& epoch) -> int;
+
+// seconds since epoch of the first day of the month
+
+auto month_key_to_epoch(const int& month) -> int;
+
+// "MM/yyyy" string used in the tables and charts
+
+auto month_key_to_string(const int& month) -> QString;
+
+#endif
@@ -0,0 +1,264 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDate>
+#include <QDebug>
+#include <QFile>
+#include <QSqlError>
+#include <QTextStream>
+#include <algorithm>
+#include <random>
+#include "benchmark_cache.hpp"
+#include "calculations.hpp"
+#include "database.hpp"
+#include "schema.hpp"
+
+/*
+  Writes a database with synthetic investments and benchmarks. The tables are created by the same functions used by
+  the graphical interface and the derived columns, the portfolio and the calculation hashes are saved like after a
+  "Calculate Portfolio". The generated file can be used in place of the real one to profile the program with large
+  portfolios.
+*/
+
+namespace {
+
+auto write_benchmark(const QSqlDatabase& db, const QString& table_name, const QVector<int>& months,
+                     const QVector<double>& values) -> bool {
+  auto database = db;
+
+  database.transaction();
+
+  auto& query = cached_query(db, "insert into " + table_name + " (date, value, accumulated) values (?, ?, ?)");
+
+  double product = 1.0;
+
+  bool success = true;
+
+  for (int n = 0; n < months.size() && success; n++) {
+    product *= values[n] * 0.01 + 1.0;
+
+    query.bindValue(0, month_key_to_epoch(months[n]));
+    query.bindValue(1, values[n]);
+    query.bindValue(2, (product - 1.0) * 100);
+
+    success = query.exec();
+  }
+
+  if (success) {
+    success = database.commit();
+  } else {
+    qDebug() << query.lastError().text().toUtf8();
+
+    database.rollback();
+  }
+
+  return success;
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+
+  parser.setApplicationDescription("Writes a database with synthetic investments and benchmarks");
+  parser.addHelpOption();
+  parser.addPositionalArgument("file", "Database file that will be created.");
+
+  QCommandLineOption funds_option({"f", "funds"}, "Number of investments.", "count", "20");
+  QCommandLineOption months_option({"m", "months"}, "Number of months of history.", "count", "120");
+  QCommandLineOption benchmarks_option({"b", "benchmarks"}, "Number of benchmarks besides the inflation.", "count",
+                                       "2");
+  QCommandLineOption missing_option({"x", "missing"}, "Fraction of the months that are left out of each table.",
+                                    "ratio", "0.05");
+  QCommandLineOption seed_option({"s", "seed"}, "Seed of the random number generator.", "seed", "1");
+  QCommandLineOption overwrite_option({"w", "overwrite"}, "Replace the file if it already exists.");
+
+  parser.addOption(funds_option);
+  parser.addOption(months_option);
+  parser.addOption(benchmarks_option);
+  parser.addOption(missing_option);
+  parser.addOption(seed_option);
+  parser.addOption(overwrite_option);
+
+  parser.process(app);
+
+  QTextStream err(stderr);
+
+  if (parser.positionalArguments().size() != 1) {
+    parser.showHelp(1);
+  }
+
+  const auto path = parser.positionalArguments().first();
+
+  if (QFile::exists(path)) {
+    if (!parser.isSet(overwrite_option)) {
+      err << path << " already exists. Use --overwrite to replace it\n";
+
+      return 1;
+    }
+
+    for (const auto& suffix : {"", "-wal", "-shm"}) {
+      QFile::remove(path + suffix);
+    }
+  }
+
+  const int n_funds = std::max(parser.value(funds_option).toInt(), 1);
+  const int n_months = std::max(parser.value(months_option).toInt(), 1);
+  const int n_benchmarks = std::max(parser.value(benchmarks_option).toInt(), 0);
+  const double missing = std::clamp(parser.value(missing_option).toDouble(), 0.0, 0.9);
+
+  std::mt19937_64 rng(parser.value(seed_option).toULongLong());
+
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::normal_distribution<double> market_return(0.6, 1.5);
+  std::normal_distribution<double> own_return(0.0, 1.0);
+  std::uniform_int_distribution<int> late_start(0, n_months / 4);
+
+  auto db = open_database(path);
+
+  if (!db.isOpen()) {
+    err << "failed to open the database file: " << path << "\n";
+
+    return 1;
+  }
+
+  create_metadata_tables(db);
+  create_portfolio_table(db);
+  create_benchmark_table(db, "inflation", true);
+
+  // the history ends in the current month like in a database that is still in use
+
+  const auto today = QDate::currentDate();
+
+  const int first_month = today.year() * 12 + today.month() - 1 - n_months + 1;
+
+  // Months kept in a table. The first one is always there so the table is never empty
+
+  const auto make_months = [&](const int& start) {
+    QVector<int> months;
+
+    for (int n = start; n < n_months; n++) {
+      if (n == start || uniform(rng) >= missing) {
+        months.append(first_month + n);
+      }
+    }
+
+    return months;
+  };
+
+  // Benchmarks. They are also the source of the part of the investment returns that is shared by all of them
+
+  QVector<double> market(n_months);
+
+  for (auto& value : market) {
+    value = market_return(rng);
+  }
+
+  for (int b = 0; b <= n_benchmarks; b++) {
+    const auto name = (b == 0) ? QString("inflation") : QString("Benchmark%1").arg(b);
+
+    if (b > 0) {
+      if (!create_benchmark_table(db, name)) {
+        return 1;
+      }
+
+      register_table(db, name, TableType::Benchmark);
+    }
+
+    const auto months = make_months(0);
+
+    QVector<double> values;
+
+    for (const auto& month : months) {
+      values.append((b == 0) ? 0.3 + 0.4 * uniform(rng) : market[month - first_month] + 0.5 * own_return(rng));
+    }
+
+    if (!write_benchmark(db, name, months, values)) {
+      return 1;
+    }
+  }
+
+  // The inflation is read back the same way the program does so the saved hashes match the ones it calculates
+
+  BenchmarkCache benchmarks;
+
+  benchmarks.set_database(db);
+
+  const auto inflation = benchmarks.get("inflation");
+
+  // Investments. Names follow the ones given by the "add table" button
+
+  QVector<FundCalculation> calculations(n_funds);
+  QVector<QString> names;
+
+  for (int k = 0; k < n_funds; k++) {
+    const auto name = QString("Investment%1").arg(k);
+
+    if (!create_fund_table(db, name)) {
+      return 1;
+    }
+
+    register_table(db, name, TableType::Investment);
+
+    auto& series = calculations[k].series;
+
+    const auto months = make_months(late_start(rng));
+
+    series.resize(months.size());
+
+    const double beta = 0.5 + uniform(rng);
+
+    double balance = 1000.0 + 9000.0 * uniform(rng);
+
+    for (int n = 0; n < series.size(); n++) {
+      series.months[n] = months[n];
+      series.dates[n] = month_key_to_epoch(months[n]);
+
+      series.deposit[n] = (n == 0 || uniform(rng) < 0.3) ? 100.0 + 900.0 * uniform(rng) : 0.0;
+      series.withdrawal[n] = (uniform(rng) < 0.05) ? 0.1 * balance * uniform(rng) : 0.0;
+      series.starting_balance[n] = balance;
+
+      const double monthly_return = beta * market[months[n] - first_month] + own_return(rng);
+
+      balance = (balance + series.deposit[n] - series.withdrawal[n]) * (1.0 + 0.01 * monthly_return);
+
+      series.ending_balance[n] = balance;
+    }
+
+    calculations[k].inflation = inflation;
+
+    calculate_fund(calculations[k]);
+
+    if (!write_fund_series(db, name, series)) {
+      return 1;
+    }
+
+    names.append(name);
+  }
+
+  // the portfolio hash uses the tables in the order the program loads them
+
+  QVector<QString> sorted_names = load_table_names(db, TableType::Investment);
+  QVector<QByteArray> hashes;
+  QVector<FundSeries const*> funds;
+
+  for (auto& name : sorted_names) {
+    const auto& calculation = calculations[names.indexOf(name)];
+
+    save_calculation_hash(db, name, calculation.hash);
+
+    hashes.append(calculation.hash);
+    funds.append(&calculation.series);
+  }
+
+  if (!write_fund_series(db, "portfolio", calculate_portfolio(funds, inflation))) {
+    return 1;
+  }
+
+  save_calculation_hash(db, "portfolio", portfolio_hash(sorted_names, hashes));
+
+  err << "investments: " << n_funds << " benchmarks: " << n_benchmarks + 1 << " months: " << n_months << "\n";
+
+  return 0;
+}
@@ -4,7 +4,10 @@
 #include <QSqlError>
 #include <QSqlRecord>
 #include <QStandardPaths>
+#include <QTimer>
+#include "database.hpp"
 #include "effects.hpp"
+#include "schema.hpp"
 #include "table_benchmarks.hpp"
 #include "table_fund.hpp"
 
@@ -50,6 +53,8 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
     auto table =
         dynamic_cast<TableBenchmarks*>(stackedwidget_benchmarks->widget(stackedwidget_benchmarks->currentIndex()));
 
+    benchmark_cache.clear();
+
     table->calculate();
   });
 
@@ -63,6 +68,8 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
     table->calculate();
   });
 
+  connect(&calculation_service, &CalculationService::fundsCalculated, this, &MainWindow::process_portfolio);
+
   connect(button_database_file, &QPushButton::clicked, this, [&]() {
     auto path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDesktopServices::openUrl(path);
@@ -100,8 +107,6 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
   if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
     qCritical("sqlite driver is not available!");
   } else {
-    db = QSqlDatabase::addDatabase("QSQLITE");
-
     auto path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
 
     if (!QDir(path).exists()) {
@@ -112,32 +117,31 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
 
     qDebug() << "Database file: " + path.toLatin1();
 
-    db.setDatabaseName(path);
+    db = open_database(path);
 
-    if (db.open()) {
+    if (db.isOpen()) {
       qDebug("The database file was opened!");
 
-      load_inflation_table();
+      benchmark_cache.set_database(db);
+      calculation_service.set_database(db);
 
-      load_saved_tables();
+      create_metadata_tables(db);
+      migrate_metadata(db);
 
-      auto fund_tables = QVector<TableFund const*>();
+      load_inflation_table();
 
-      for (int n = 0; n < stackedwidget_funds->count(); n++) {
-        fund_tables.append(dynamic_cast<TableFund const*>(stackedwidget_funds->widget(n)));
-      }
+      load_saved_tables();
 
-      auto portfolio_table = load_portfolio_table();
-      auto cf = load_compare_funds();
-      auto fc = load_fund_correlation();
-      auto fpca = load_fund_pca();
+      load_portfolio_table();
+      load_compare_funds();
+      load_fund_correlation();
+      load_fund_pca();
+      load_portfolio_projection();
 
-      // This has to be done after loading the other tables
+      // The investment tables are loaded and calculated only after the window is shown. The portfolio is processed
+      // when their calculation finishes in the background
 
-      portfolio_table->process_fund_tables(fund_tables);
-      cf->process(fund_tables, portfolio_table);
-      fc->process(fund_tables, portfolio_table);
-      fpca->process(fund_tables);
+      QTimer::singleShot(0, this, [&]() { calculation_service.calculate_funds(fund_tables()); });
     } else {
       qCritical("Failed to open the database file!");
     }
@@ -146,27 +150,21 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
   show();
 }
 
+MainWindow::~MainWindow() = default;
+
 auto MainWindow::load_portfolio_table() -> TablePortfolio* {
-  auto query = QSqlQuery(db);
-
-  query.prepare(
-      "create table if not exists portfolio"
-      " (id integer primary key, date int default (cast(strftime('%s','now') as int)),"
-      " deposit real default 0.0, withdrawal real default 0.0, starting_balance real default 0.0,"
-      " ending_balance real default 0.0, accumulated_deposit real default 0.0, accumulated_withdrawal real default 0.0,"
-      " net_deposit real default 0.0, net_balance real default 0.0, net_return real default 0.0,"
-      " net_return_perc real default 0.0, accumulated_net_return real default 0.0, "
-      " accumulated_net_return_perc real default 0.0, real_return_perc real default 0.0,"
-      " accumulated_real_return_perc real default 0.0)");
-
-  if (!query.exec()) {
+  if (!create_portfolio_table(db)) {
     qDebug("Failed to create table portfolio. Maybe it already exists.");
   }
 
   auto table = new TablePortfolio();
 
   table->set_database(db);
-  table->init_model();
+  table->benchmarks = &benchmark_cache;
+
+  // the portfolio is the first page. It is loaded right away
+
+  table->ensure_loaded();
 
   connect(table, &TablePortfolio::getBenchmarkTables, this, [=]() {
     for (int n = 0; n < stackedwidget_benchmarks->count(); n++) {
@@ -214,25 +212,29 @@ auto MainWindow::load_fund_pca() -> FundPCA* {
   return fpca;
 }
 
-void MainWindow::load_inflation_table() {
-  auto query = QSqlQuery(db);
+auto MainWindow::load_portfolio_projection() -> PortfolioProjection* {
+  auto pp = new PortfolioProjection(db);
+
+  stackedwidget_portfolio->addWidget(pp);
+
+  listwidget_portfolio->addItem("Projection");
 
-  query.prepare(
-      "create table if not exists inflation (id integer primary key,"
-      " date int default (cast(strftime('%s','now') as int)),value real default 0.0,accumulated real default 0.0)");
+  return pp;
+}
 
-  if (query.exec()) {
+void MainWindow::load_inflation_table() {
+  if (create_benchmark_table(db, "inflation", true)) {
     auto* table = new TableBenchmarks();
 
     table->set_database(db);
+    table->benchmarks = &benchmark_cache;
     table->name = "inflation";
-    table->init_model();
+
+    // the model is loaded when the table is shown
 
     stackedwidget_benchmarks->addWidget(table);
 
     listwidget_tables_benchmarks->addItem("inflation");
-
-    table->calculate();
   } else {
     qDebug("Failed to create table inflation. Maybe it already exists.");
   }
@@ -241,13 +243,9 @@ void MainWindow::load_inflation_table() {
 void MainWindow::add_benchmark_table() {
   auto name = QString("Benchmark%1").arg(stackedwidget_benchmarks->count());
 
-  auto query = QSqlQuery(db);
-
-  query.prepare("create table " + name + " (id integer primary key," +
-                " date int default (cast(strftime('%s','now') as int))," + " value real default 0.0," +
-                " accumulated real default 0.0)");
+  if (create_benchmark_table(db, name)) {
+    register_table(db, name, TableType::Benchmark);
 
-  if (query.exec()) {
     load_table<TableBenchmarks>(name, stackedwidget_benchmarks, listwidget_tables_benchmarks);
 
     stackedwidget_benchmarks->setCurrentIndex(stackedwidget_benchmarks->count() - 1);
@@ -261,18 +259,9 @@ void MainWindow::add_benchmark_table() {
 void MainWindow::add_fund_table() {
   auto name = QString("Investment%1").arg(stackedwidget_funds->count());
 
-  auto query = QSqlQuery(db);
+  if (create_fund_table(db, name)) {
+    register_table(db, name, TableType::Investment);
 
-  query.prepare(
-      "create table " + name + " (id integer primary key, date int default (cast(strftime('%s','now') as int))," +
-      " deposit real default 0.0, withdrawal real default 0.0, starting_balance real default 0.0," +
-      " ending_balance real default 0.0, accumulated_deposit real default 0.0, accumulated_withdrawal real default 0.0,"
-      " net_deposit real default 0.0, net_balance real default 0.0, net_return real default 0.0," +
-      " net_return_perc real default 0.0, accumulated_net_return real default 0.0, "
-      " accumulated_net_return_perc real default 0.0, real_return_perc real default 0.0," +
-      " accumulated_real_return_perc real default 0.0)");
-
-  if (query.exec()) {
     auto table = load_table<TableFund>(name, stackedwidget_funds, listwidget_tables_funds);
 
     stackedwidget_funds->setCurrentIndex(stackedwidget_funds->count() - 1);
@@ -292,81 +281,35 @@ void MainWindow::add_fund_table() {
 }
 
 void MainWindow::load_saved_tables() {
-  auto query = QSqlQuery(db);
-
-  query.prepare("select name from sqlite_master where type='table'");
+  const auto investments = load_table_names(db, TableType::Investment);
+  const auto benchmarks = load_table_names(db, TableType::Benchmark);
 
-  if (query.exec()) {
-    auto names = QVector<QString>();
+  for (auto& name : investments) {
+    qInfo() << "Found table: " + name.toUtf8();
 
-    while (query.next()) {
-      auto name = query.value(0).toString();
-
-      if (name != "portfolio" && name != "inflation") {
-        names.append(name);
-      }
-    }
-
-    std::sort(names.begin(), names.end());
-
-    auto benchmarks = QVector<QString>();
-    auto investments = QVector<QString>();
-
-    for (auto& name : names) {
-      qInfo() << "Found table: " + name.toUtf8();
-
-      auto query = QSqlQuery(db);
-
-      query.prepare("select * from " + name);
+    auto table = load_table<TableFund>(name, stackedwidget_funds, listwidget_tables_funds);
 
-      if (query.exec()) {
-        int n_cols = query.record().count();
+    connect(table, &TableFund::getBenchmarkTables, this, [=]() {
+      for (int n = 0; n < stackedwidget_benchmarks->count(); n++) {
+        auto btable = dynamic_cast<TableBenchmarks*>(stackedwidget_benchmarks->widget(n));
 
-        if (n_cols == 4) {
-          benchmarks.append(name);
-        } else {
-          investments.append(name);
-        }
+        table->show_benchmark(btable);
       }
-    }
-
-    for (auto& name : investments) {
-      auto table = load_table<TableFund>(name, stackedwidget_funds, listwidget_tables_funds);
-
-      connect(table, &TableFund::getBenchmarkTables, this, [=]() {
-        for (int n = 0; n < stackedwidget_benchmarks->count(); n++) {
-          auto btable = dynamic_cast<TableBenchmarks*>(stackedwidget_benchmarks->widget(n));
-
-          table->show_benchmark(btable);
-        }
-      });
-    }
-
-    for (auto& name : benchmarks) {
-      load_table<TableBenchmarks>(name, stackedwidget_benchmarks, listwidget_tables_benchmarks);
-    }
-
-    for (int n = 0; n < stackedwidget_benchmarks->count(); n++) {
-      auto table = dynamic_cast<TableBenchmarks*>(stackedwidget_benchmarks->widget(n));
-
-      table->calculate();
-    }
+    });
+  }
 
-    for (int n = 0; n < stackedwidget_funds->count(); n++) {
-      auto table = dynamic_cast<TableFund*>(stackedwidget_funds->widget(n));
+  for (auto& name : benchmarks) {
+    qInfo() << "Found table: " + name.toUtf8();
 
-      table->calculate();
-    }
+    load_table<TableBenchmarks>(name, stackedwidget_benchmarks, listwidget_tables_benchmarks);
+  }
 
-    if (listwidget_tables_funds->count() > 0) {
-      listwidget_tables_funds->setCurrentRow(0);
-    }
+  if (listwidget_tables_funds->count() > 0) {
+    listwidget_tables_funds->setCurrentRow(0);
+  }
 
-    if (listwidget_tables_benchmarks->count() > 0) {
-      listwidget_tables_benchmarks->setCurrentRow(0);
-    }
-  } else {
-    qDebug("Failed to get table names!");
+  if (listwidget_tables_benchmarks->count() > 0) {
+    listwidget_tables_benchmarks->setCurrentRow(0);
   }
 }
 
@@ -385,11 +328,21 @@ void MainWindow::on_listwidget_item_changed(QListWidgetItem* item, QListWidget*
     query.prepare("alter table " + table->name + " rename to " + new_name);
 
     if (query.exec()) {
+      benchmark_cache.clear();
+
+      rename_table_metadata(db, table->name, new_name);
+
+      clear_statement_cache(db);
+
       table->name = new_name;
 
       lw->currentItem()->setText(new_name.toUpper());
 
-      table->init_model();
+      // a table that was not shown yet is loaded with the new name when it is shown
+
+      if (table->is_loaded()) {
+        table->init_model();
+      }
 
       table->set_chart1_title(new_name);
       table->set_chart2_title(new_name);
@@ -431,6 +384,12 @@ void MainWindow::remove_table(QListWidget* lw, QStackedWidget* sw) {
     if (!query.exec()) {
       qDebug() << "Failed remove table " + table->name.toUtf8() + ". Maybe has already been removed.";
     }
+
+    unregister_table(db, table->name);
+
+    clear_statement_cache(db);
+
+    benchmark_cache.clear();
   }
 }
 
@@ -463,6 +422,8 @@ void MainWindow::clear_table(const QStackedWidget* sw) {
     query.prepare("delete from " + table->name);
 
     if (query.exec()) {
+      benchmark_cache.clear();
+
       table->model->select();
 
       table->clear_charts();
@@ -516,25 +477,47 @@ void MainWindow::on_save_table_portfolio() {
   }
 }
 
-void MainWindow::save_table(const QStackedWidget* sw) {
+auto MainWindow::save_table(const QStackedWidget* sw) -> bool {
   auto table = dynamic_cast<TableBase*>(sw->widget(sw->currentIndex()));
 
   if (!table->model->submitAll()) {
     qDebug() << "failed to save table " + table->name.toUtf8() + " to the database";
 
     qDebug() << table->model->lastError().text().toUtf8();
+
+    return false;
   }
+
+  return true;
 }
 
 void MainWindow::on_save_table_fund() {
-  save_table(stackedwidget_funds);
+  if (!save_table(stackedwidget_funds)) {
+    return;
+  }
+
+  auto table = dynamic_cast<TableFund*>(stackedwidget_funds->widget(stackedwidget_funds->currentIndex()));
+
+  table->save_results_hash();
 }
 
 void MainWindow::on_save_table_benchmark() {
   save_table(stackedwidget_benchmarks);
+
+  benchmark_cache.clear();
 }
 
-void MainWindow::on_calculate_portfolio() {
+auto MainWindow::fund_tables() -> QVector<TableFund*> {
+  auto tables = QVector<TableFund*>();
+
+  for (int n = 0; n < stackedwidget_funds->count(); n++) {
+    tables.append(dynamic_cast<TableFund*>(stackedwidget_funds->widget(n)));
+  }
+
+  return tables;
+}
+
+void MainWindow::process_portfolio() {
   auto fund_tables = QVector<TableFund const*>();
 
   for (int n = 0; n < stackedwidget_funds->count(); n++) {
@@ -556,4 +539,16 @@ void MainWindow::on_calculate_portfolio() {
   auto fpca = dynamic_cast<FundPCA*>(stackedwidget_portfolio->widget(3));
 
   fpca->process(fund_tables);
+
+  auto pp = dynamic_cast<PortfolioProjection*>(stackedwidget_portfolio->widget(4));
+
+  pp->process(fund_tables);
+}
+
+void MainWindow::on_calculate_portfolio() {
+  benchmark_cache.clear();
+
+  // the investment tables are brought up to date first. process_portfolio() is called when they are done
+
+  calculation_service.calculate_funds(fund_tables());
 }
\ No newline at end of file
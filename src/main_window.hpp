@@ -5,9 +5,12 @@
 #include <QSettings>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include "benchmark_cache.hpp"
+#include "calculation_service.hpp"
 #include "compare_funds.hpp"
 #include "fund_correlation.hpp"
 #include "fund_pca.hpp"
+#include "portfolio_projection.hpp"
 #include "table_portfolio.hpp"
 #include "ui_main_window.h"
 
@@ -15,17 +18,23 @@ class MainWindow : public QMainWindow, private Ui::MainWindow {
   Q_OBJECT
  public:
   explicit MainWindow(QMainWindow* parent = nullptr);
+  ~MainWindow() override;
 
  private:
   QSettings qsettings;
 
   QSqlDatabase db;
 
+  BenchmarkCache benchmark_cache;
+
+  CalculationService calculation_service;
+
   auto load_portfolio_table() -> TablePortfolio*;
   void load_inflation_table();
   auto load_compare_funds() -> CompareFunds*;
   auto load_fund_correlation() -> FundCorrelation*;
   auto load_fund_pca() -> FundPCA*;
+  auto load_portfolio_projection() -> PortfolioProjection*;
 
   void add_benchmark_table();
   void add_fund_table();
@@ -33,7 +42,7 @@ class MainWindow : public QMainWindow, private Ui::MainWindow {
   void clear_table(const QStackedWidget* sw);
   void remove_table(QListWidget* lw, QStackedWidget* sw);
 
-  static void save_table(const QStackedWidget* sw);
+  static auto save_table(const QStackedWidget* sw) -> bool;
 
   void on_save_table_fund();
   void on_clear_table_fund();
@@ -43,6 +52,9 @@ class MainWindow : public QMainWindow, private Ui::MainWindow {
   void on_clear_table_benchmark();
   void on_remove_table_benchmark();
 
+  auto fund_tables() -> QVector<TableFund*>;
+
+  void process_portfolio();
   void on_calculate_portfolio();
   void on_save_table_portfolio();
   void on_clear_table_portfolio();
@@ -54,8 +66,10 @@ class MainWindow : public QMainWindow, private Ui::MainWindow {
     auto table = new T();
 
     table->set_database(db);
+    table->benchmarks = &benchmark_cache;
     table->name = name;
-    table->init_model();
+
+    // the model is loaded when the table is shown. See TableBase::ensure_loaded() and FundJob::read_series
 
     sw->addWidget(table);
 
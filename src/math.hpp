@@ -2,7 +2,136 @@
 #define MATH_HPP
 
 #include <QVector>
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include <Eigen/QR>
+#include <Eigen/SVD>
+#include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <numeric>
+
+/*
+  Online mean and variance using Welford's algorithm
+  https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Welford's_online_algorithm
+
+  Values can also be removed. This is what allows rolling windows to be updated in constant time.
+*/
+
+template <class T>
+class RunningStats {
+ public:
+  void add(const T& x) {
+    count++;
+
+    const T delta = x - avg;
+
+    avg += delta / count;
+
+    m2 += delta * (x - avg);
+  }
+
+  void remove(const T& x) {
+    if (count <= 1) {
+      clear();
+
+      return;
+    }
+
+    count--;
+
+    const T delta = x - avg;
+
+    avg -= delta / count;
+
+    m2 = std::max(m2 - delta * (x - avg), static_cast<T>(0));
+  }
+
+  void clear() {
+    count = 0;
+    avg = 0;
+    m2 = 0;
+  }
+
+  [[nodiscard]] auto size() const -> int { return count; }
+
+  [[nodiscard]] auto mean() const -> T { return avg; }
+
+  // sum of the squared deviations from the mean
+
+  [[nodiscard]] auto sum_squares() const -> T { return m2; }
+
+  [[nodiscard]] auto sample_variance() const -> T { return (count > 1) ? m2 / (count - 1) : 0; }
+
+ private:
+  int count = 0;
+
+  T avg = 0;
+  T m2 = 0;
+};
+
+/*
+  Online co-moment of two variables. Same idea as RunningStats but also keeping track of the sum of the products of
+  the deviations https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Covariance
+*/
+
+template <class T>
+class RunningCovariance {
+ public:
+  void add(const T& a, const T& b) {
+    const T delta_a = a - stats_a.mean();
+
+    stats_a.add(a);
+    stats_b.add(b);
+
+    co_moment += delta_a * (b - stats_b.mean());
+  }
+
+  void remove(const T& a, const T& b) {
+    if (stats_a.size() <= 1) {
+      clear();
+
+      return;
+    }
+
+    const T avg_b = stats_b.mean();
+
+    stats_a.remove(a);
+    stats_b.remove(b);
+
+    co_moment -= (a - stats_a.mean()) * (b - avg_b);
+  }
+
+  void clear() {
+    stats_a.clear();
+    stats_b.clear();
+
+    co_moment = 0;
+  }
+
+  [[nodiscard]] auto size() const -> int { return stats_a.size(); }
+
+  // Pearson correlation coefficient https://en.wikipedia.org/wiki/Pearson_correlation_coefficient
+
+  [[nodiscard]] auto correlation() const -> T {
+    const T stddev_a = std::sqrt(stats_a.sum_squares());
+    const T stddev_b = std::sqrt(stats_b.sum_squares());
+
+    const float tol = 0.001F;
+
+    if (stddev_a > tol && stddev_b > tol) {
+      return co_moment / (stddev_a * stddev_b);
+    }
+
+    return co_moment;
+  }
+
+ private:
+  RunningStats<T> stats_a;
+  RunningStats<T> stats_b;
+
+  T co_moment = 0;
+};
 
 template <class T>
 auto second_derivative(const QVector<T>& input) -> QVector<T> {
@@ -23,71 +152,424 @@ auto second_derivative(const QVector<T>& input) -> QVector<T> {
   return output;
 }
 
-template <class T>
-auto standard_deviation(const QVector<T>& input) -> QVector<T> {
-  QVector<T> output(input.size(), 0);
+/*
+  Replaces monthly returns in percent by the returns accumulated since the first value
 
-  // Calculating the standard deviation https://en.wikipedia.org/wiki/Standard_deviation
+    output[n] = ((1 + input[0] / 100) * ... * (1 + input[n] / 100) - 1) * 100
 
-  T accumulated = 0.0;
+  The product is calculated as exp(sum(log(1 + input[i] / 100))). log1p and expm1 keep the precision of small returns
+  that would be lost in 1 + r and in product - 1. The logarithm and the exponential are independent for each value and
+  can be vectorized. The only step that depends on the previous value is a running sum. Everything is done in place.
+  Reverse iterators can be used for series stored from the newest to the oldest month.
+*/
 
-  for (int n = 0; n < input.size(); n++) {
-    accumulated += input[n];
+template <class Iterator>
+void compound_returns(Iterator first, Iterator last) {
+  using T = typename std::iterator_traits<Iterator>::value_type;
+
+  // the logarithm is not defined for a loss of 100% or more. In that case the product is used directly
 
-    T avg = accumulated / (n + 1);
+  if (std::any_of(first, last, [](const T& v) { return v <= T(-100); })) {
+    T product = 1;
 
-    T sum = 0.0;
+    for (auto it = first; it != last; ++it) {
+      product *= *it * T(0.01) + T(1);
 
-    for (int m = 0; m < n; m++) {
-      sum += (input[m] - avg) * (input[m] - avg);
+      *it = (product - T(1)) * 100;
     }
 
-    sum = (n > 0) ? sum / n : sum;
+    return;
+  }
+
+  std::transform(first, last, first, [](const T& v) { return std::log1p(v * T(0.01)); });
+
+  std::partial_sum(first, last, first);
+
+  std::transform(first, last, first, [](const T& v) { return std::expm1(v) * 100; });
+}
+
+template <class T>
+void compound_returns(QVector<T>& values) {
+  compound_returns(values.begin(), values.end());
+}
+
+/*
+  Standard deviation https://en.wikipedia.org/wiki/Standard_deviation
 
-    output[n] = std::sqrt(sum);
+  output[n] is the sample standard deviation of the last "window" values ending at n. When window <= 0 the window
+  grows with n and the whole history up to n is used.
+*/
+
+template <class T>
+auto standard_deviation(const QVector<T>& input, const int& window = 0) -> QVector<T> {
+  QVector<T> output(input.size(), 0);
+
+  RunningStats<T> stats;
+
+  for (int n = 0; n < input.size(); n++) {
+    stats.add(input[n]);
+
+    if (window > 0 && n >= window) {
+      stats.remove(input[n - window]);
+    }
+
+    output[n] = std::sqrt(stats.sample_variance());
   }
 
   return output;
 }
 
+/*
+  Pearson correlation coefficient https://en.wikipedia.org/wiki/Pearson_correlation_coefficient
+
+  Same window convention used in standard_deviation.
+*/
+
 template <class T>
-auto correlation_coefficient(const QVector<T>& a, const QVector<T>& b) -> QVector<T> {
+auto correlation_coefficient(const QVector<T>& a, const QVector<T>& b, const int& window = 0) -> QVector<T> {
   QVector<T> output(a.size(), 0);
-  T sum_a = 0;
-  T sum_b = 0;
 
-  // calculating the Pearson correlation coefficient https://en.wikipedia.org/wiki/Pearson_correlation_coefficient
+  RunningCovariance<T> covariance;
 
   for (int n = 0; n < a.size(); n++) {
-    sum_a += a[n];
-    sum_b += b[n];
+    covariance.add(a[n], b[n]);
 
-    T avg_a = sum_a / (n + 1);
-    T avg_b = sum_b / (n + 1);
+    if (window > 0 && n >= window) {
+      covariance.remove(a[n - window], b[n - window]);
+    }
 
-    T variance_a = 0;
-    T variance_b = 0;
+    output[n] = covariance.correlation();
+  }
 
-    for (int m = 0; m <= n; m++) {
-      variance_a += (a[m] - avg_a) * (a[m] - avg_a);
-      variance_b += (b[m] - avg_b) * (b[m] - avg_b);
+  return output;
+}
+
+/*
+  Pearson correlation matrix of the columns of data https://en.wikipedia.org/wiki/Pearson_correlation_coefficient
+
+  Each coefficient uses only the rows where both columns are valid (mask == true), the same values used by
+  RunningCovariance. The sums over those rows come from matrix products with the mask so all the pairs are calculated
+  at once
+
+    count(a, b)     = sum of m_a * m_b
+    sum(a | b)      = sum of x_a * m_b
+    squares(a | b)  = sum of x_a^2 * m_b
+    products(a, b)  = sum of x_a * x_b
+
+  with the missing values set to zero. The columns are centered on the mean of their valid values first. The moments
+  of each pair are then taken around values close to their own means and the subtractions below do not lose precision.
+*/
+
+template <class T>
+auto correlation_matrix(const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& data,
+                        const Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic>& mask)
+    -> Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> {
+  using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+  Matrix centered(data.rows(), data.cols());
+
+  for (Eigen::Index m = 0; m < data.cols(); m++) {
+    const auto count = mask.col(m).count();
+
+    const T avg = (count > 0) ? mask.col(m).select(data.col(m).array(), T(0)).sum() / count : T(0);
+
+    centered.col(m) = mask.col(m).select(data.col(m).array() - avg, T(0)).matrix();
+  }
+
+  const Matrix valid = mask.template cast<T>().matrix();
+
+  const Matrix counts = valid.transpose() * valid;
+  const Matrix sums = centered.transpose() * valid;
+  const Matrix squares = centered.cwiseAbs2().transpose() * valid;
+  const Matrix products = centered.transpose() * centered;
+
+  const T tol = 0.001;
+
+  Matrix output = Matrix::Identity(data.cols(), data.cols());
+
+  for (Eigen::Index a = 0; a < data.cols(); a++) {
+    for (Eigen::Index b = 0; b < a; b++) {
+      const T count = counts(a, b);
+
+      if (count < 2) {
+        output(a, b) = output(b, a) = T(0);
+
+        continue;
+      }
+
+      const T co_moment = products(a, b) - sums(a, b) * sums(b, a) / count;
+
+      const T stddev_a = std::sqrt(std::max(squares(a, b) - sums(a, b) * sums(a, b) / count, T(0)));
+      const T stddev_b = std::sqrt(std::max(squares(b, a) - sums(b, a) * sums(b, a) / count, T(0)));
+
+      const T value = (stddev_a > tol && stddev_b > tol) ? co_moment / (stddev_a * stddev_b) : T(0);
+
+      output(a, b) = output(b, a) = std::clamp(value, T(-1), T(1));
     }
+  }
 
-    T stddev = std::sqrt(variance_a);
-    T tstddev = std::sqrt(variance_b);
+  return output;
+}
+
+/*
+  Principal component analysis https://en.wikipedia.org/wiki/Principal_component_analysis
+
+  Each row of data is a variable (a month) and each column an observation (a series). The rows are standardized using
+  only their valid values (mask == true) and the missing values are set to zero. Instead of diagonalizing the months x
+  months covariance matrix a thin SVD of the standardized series x months matrix is used
+  https://en.wikipedia.org/wiki/Singular_value_decomposition#Thin_SVD
+  The squared singular values are proportional to the covariance eigenvalues and U * S are the projections of the
+  series on the components. The cost grows with min(series, months) instead of months^3.
+*/
+
+template <class T>
+struct PrincipalComponents {
+  // one row per series and one column per component
+
+  Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> scores;
+
+  // percentage of the total variance explained by each component
+
+  Eigen::Matrix<T, Eigen::Dynamic, 1> explained_variance;
+};
+
+template <class T>
+auto principal_components(const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& data,
+                          const Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic>& mask,
+                          const int& n_components) -> PrincipalComponents<T> {
+  using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+  Matrix standardized(data.cols(), data.rows());
+
+  const T tol = 0.0001;
 
-    for (int m = 0; m <= n; m++) {
-      output[n] += (a[m] - avg_a) * (b[m] - avg_b);
+  for (Eigen::Index n = 0; n < data.rows(); n++) {
+    const auto count = mask.row(n).count();
+
+    const T avg = (count > 0) ? mask.row(n).select(data.row(n).array(), T(0)).sum() / count : T(0);
+
+    auto column = standardized.col(n);
+
+    column = mask.row(n).select(data.row(n).array() - avg, T(0)).matrix().transpose();
+
+    const T stddev = (count > 1) ? std::sqrt(column.squaredNorm() / (count - 1)) : T(0);
+
+    if (stddev > tol) {
+      column /= stddev;
     }
+  }
 
-    const float tol = 0.001F;
+  PrincipalComponents<T> output;
+
+  const T total_variance = standardized.squaredNorm();
+
+  if (standardized.size() == 0 || total_variance <= T(0)) {
+    output.scores = Matrix::Zero(data.cols(), n_components);
+    output.explained_variance = Eigen::Matrix<T, Eigen::Dynamic, 1>::Zero(n_components);
+
+    return output;
+  }
+
+  // only U is needed. V holds the directions of the components in the months space
+
+  Eigen::BDCSVD<Matrix> svd(standardized, Eigen::ComputeThinU);
+
+  const auto& singular_values = svd.singularValues();
+
+  const Eigen::Index k = std::min(static_cast<Eigen::Index>(n_components), singular_values.size());
+
+  output.scores = Matrix::Zero(data.cols(), n_components);
+  output.explained_variance = Eigen::Matrix<T, Eigen::Dynamic, 1>::Zero(n_components);
+
+  output.scores.leftCols(k) = svd.matrixU().leftCols(k) * singular_values.head(k).asDiagonal();
+  output.explained_variance.head(k) = 100 * singular_values.head(k).array().square() / total_variance;
+
+  return output;
+}
+
+/*
+  Principal components of a sliding window of observations. Here each column of the input is a variable (a series) and
+  each row an observation (a month). The mean and the co-moment matrix are updated like in RunningStats. Adding or
+  removing an observation is a rank-one update https://en.wikipedia.org/wiki/Rank_(linear_algebra)#Rank-one_update
+  of the matrix of the deviations from the mean, so moving the window by one month does not go through the whole
+  window again. The raw sums of the products would lose precision over a long history.
+
+  The components are found by subspace iteration https://en.wikipedia.org/wiki/Power_iteration#Applications on the
+  correlation matrix. Each update starts from the components of the previous window. As consecutive windows share all
+  but one observation the previous basis is already close to the new one and a couple of iterations are usually
+  enough. Only the first update runs a full eigensolver.
+*/
+
+template <class T>
+class RollingPCA {
+ public:
+  using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+  using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+
+  RollingPCA(const int& n_variables, const int& n_components)
+      : n_components(n_components),
+        n_basis(std::min(n_components + 2, n_variables)),
+        avg(Vector::Zero(n_variables)),
+        co_moment(Matrix::Zero(n_variables, n_variables)) {}
+
+  void add(const Vector& x) {
+    count++;
+
+    const Vector delta = x - avg;
+
+    avg += delta / count;
+
+    // delta * (x - new avg)^T where x - new avg = delta * (count - 1) / count
+
+    co_moment.template selfadjointView<Eigen::Lower>().rankUpdate(delta, T(count - 1) / count);
+  }
+
+  void remove(const Vector& x) {
+    if (count <= 1) {
+      clear();
+
+      return;
+    }
+
+    count--;
+
+    const Vector delta = x - avg;
+
+    avg -= delta / count;
+
+    // delta * (x - new avg)^T where x - new avg = delta * (count + 1) / count
 
-    if (stddev > tol && tstddev > tol) {
-      output[n] /= (stddev * tstddev);
+    co_moment.template selfadjointView<Eigen::Lower>().rankUpdate(delta, -T(count + 1) / count);
+  }
+
+  void clear() {
+    count = 0;
+
+    avg.setZero();
+    co_moment.setZero();
+  }
+
+  [[nodiscard]] auto size() const -> int { return count; }
+
+  // percentage of the variance explained by each one of the first components of the current window
+
+  auto update() -> Vector {
+    Vector output = Vector::Zero(n_components);
+
+    if (count < 2 || n_basis < 1) {
+      return output;
+    }
+
+    // https://en.wikipedia.org/wiki/Sample_mean_and_covariance#Sample_covariance
+
+    Matrix covariance = co_moment.template selfadjointView<Eigen::Lower>();
+
+    covariance /= (count - 1);
+
+    const T tol = 0.0001;
+
+    const Vector stddev = covariance.diagonal().cwiseMax(T(0)).cwiseSqrt();
+    const Vector inverse = (stddev.array() > tol).select(stddev.array().inverse(), T(0)).matrix();
+
+    const Matrix correlation = inverse.asDiagonal() * covariance * inverse.asDiagonal();
+
+    const T total_variance = correlation.trace();
+
+    if (total_variance <= tol) {
+      return output;
     }
+
+    const int k = std::min(n_components, n_basis);
+
+    Vector eigenvalues;
+
+    if (basis.rows() != correlation.rows()) {
+      Eigen::SelfAdjointEigenSolver<Matrix> solver(correlation);
+
+      // the solver sorts the eigenvalues in increasing order
+
+      basis = solver.eigenvectors().rightCols(n_basis).rowwise().reverse();
+      eigenvalues = solver.eigenvalues().tail(n_basis).reverse();
+    } else {
+      const int max_iterations = 50;
+
+      Vector previous;
+
+      for (int n = 0; n < max_iterations; n++) {
+        const Matrix product = correlation * basis;
+
+        basis = Eigen::HouseholderQR<Matrix>(product).householderQ() * Matrix::Identity(product.rows(), n_basis);
+
+        // Rayleigh-Ritz. Rotates the basis so its columns are the eigenvector estimates in decreasing order
+
+        Eigen::SelfAdjointEigenSolver<Matrix> solver(basis.transpose() * correlation * basis);
+
+        basis = basis * solver.eigenvectors().rowwise().reverse();
+        eigenvalues = solver.eigenvalues().reverse();
+
+        // only the components that are returned have to converge. The extra vectors are slower to converge
+
+        if (n > 0 && (eigenvalues.head(k) - previous).cwiseAbs().maxCoeff() < 1e-6 * total_variance) {
+          break;
+        }
+
+        previous = eigenvalues.head(k);
+      }
+    }
+
+    output.head(k) = 100 * eigenvalues.head(k) / total_variance;
+
+    return output;
+  }
+
+ private:
+  int count = 0;
+  int n_components;
+  int n_basis;  // a few more vectors than the components make the subspace iteration converge faster
+
+  Vector avg;
+  Matrix co_moment;  // sum of the products of the deviations from the mean. Only the lower triangle is updated
+  Matrix basis;
+};
+
+/*
+  Explained variance of the first components of the rolling window of rows ending at each row of data. Same window
+  convention used in standard_deviation. Missing values (mask == false) are replaced by the average of the valid
+  values in the same row.
+*/
+
+template <class T>
+auto rolling_explained_variance(const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& data,
+                                const Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic>& mask,
+                                const int& window,
+                                const int& n_components) -> Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> {
+  using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+  Matrix output = Matrix::Zero(data.rows(), n_components);
+
+  // rows are added and removed as columns
+
+  Matrix filled(data.cols(), data.rows());
+
+  RollingPCA<T> pca(static_cast<int>(data.cols()), n_components);
+
+  for (Eigen::Index n = 0; n < data.rows(); n++) {
+    const auto count = mask.row(n).count();
+
+    const T avg = (count > 0) ? mask.row(n).select(data.row(n).array(), T(0)).sum() / count : T(0);
+
+    filled.col(n) = mask.row(n).select(data.row(n).array(), avg).matrix().transpose();
+
+    pca.add(filled.col(n));
+
+    if (window > 0 && n >= window) {
+      pca.remove(filled.col(n - window));
+    }
+
+    output.row(n) = pca.update().transpose();
   }
 
   return output;
 }
 
-#endif
\ No newline at end of file
+#endif
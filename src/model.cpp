@@ -1,6 +1,7 @@
 #include "model.hpp"
 #include <QColor>
 #include <QDateTime>
+#include <algorithm>
 
 Model::Model(const QSqlDatabase& db, QObject* parent) : QSqlTableModel(parent, db) {}
 
@@ -39,6 +40,18 @@ auto Model::data(const QModelIndex& index, int role) const -> QVariant {
 }
 
 auto Model::setData(const QModelIndex& index, const QVariant& value, int role) -> bool {
+  if (!convert_and_set_data(index, value, role)) {
+    return false;
+  }
+
+  // a new date may change the order of the rows
+
+  dirty_row = (index.column() == 1) ? all_rows : std::max(dirty_row, index.row());
+
+  return true;
+}
+
+auto Model::convert_and_set_data(const QModelIndex& index, const QVariant& value, int role) -> bool {
   if (role != Qt::EditRole) {
     return false;
   }
@@ -72,4 +85,38 @@ auto Model::setData(const QModelIndex& index, const QVariant& value, int role) -
   }
 
   return false;
+}
+
+auto Model::epoch(const int& row) const -> int {
+  return QSqlTableModel::data(index(row, 1), Qt::EditRole).toInt();
+}
+
+auto Model::select() -> bool {
+  dirty_row = all_rows;
+
+  return QSqlTableModel::select();
+}
+
+auto Model::insertRows(int row, int count, const QModelIndex& parent) -> bool {
+  dirty_row = all_rows;
+
+  return QSqlTableModel::insertRows(row, count, parent);
+}
+
+auto Model::removeRows(int row, int count, const QModelIndex& parent) -> bool {
+  dirty_row = all_rows;
+
+  return QSqlTableModel::removeRows(row, count, parent);
+}
+
+auto Model::take_dirty_row() -> int {
+  const int row = dirty_row;
+
+  dirty_row = -1;
+
+  return row;
+}
+
+void Model::set_value(const int& row, const int& column, const double& value) {
+  QSqlTableModel::setData(index(row, column), value, Qt::EditRole);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <QLocale>
 #include <QSqlTableModel>
+#include <limits>
 
 class Model : public QSqlTableModel {
  public:
@@ -15,8 +16,36 @@ class Model : public QSqlTableModel {
 
   auto setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) -> bool override;
 
+  // value of the date column in seconds since epoch. It skips the "MM/yyyy" formatting done in data()
+
+  [[nodiscard]] auto epoch(const int& row) const -> int;
+
+  auto select() -> bool override;
+
+  auto insertRows(int row, int count, const QModelIndex& parent = QModelIndex()) -> bool override;
+
+  auto removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) -> bool override;
+
+  /*
+    Largest row edited through setData since the last call. As the rows are sorted in descending date order the rows
+    from 0 to the returned value are the ones that have to be recalculated. It returns -1 if nothing was edited and
+    all_rows if the rows were inserted, removed, reloaded or had their dates changed.
+  */
+
+  auto take_dirty_row() -> int;
+
+  static constexpr int all_rows = std::numeric_limits<int>::max();
+
+  // used by the calculations to write their results without marking the row as edited
+
+  void set_value(const int& row, const int& column, const double& value);
+
  private:
   QLocale locale;
+
+  int dirty_row = all_rows;
+
+  auto convert_and_set_data(const QModelIndex& index, const QVariant& value, int role) -> bool;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "portfolio_projection.hpp"
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include "chart_funcs.hpp"
+#include "effects.hpp"
+
+PortfolioProjection::PortfolioProjection(const QSqlDatabase& database, QWidget* parent)
+    : db(database),
+      chart(new QChart()),
+      callout(new Callout(chart)),
+      generation(std::make_shared<std::atomic<int>>(0)) {
+  setupUi(this);
+
+  callout->hide();
+
+  // shadow effects
+
+  frame_chart->setGraphicsEffect(card_shadow());
+  frame_simulation->setGraphicsEffect(card_shadow());
+  frame_plan->setGraphicsEffect(card_shadow());
+  frame_progress->setGraphicsEffect(card_shadow());
+  button_run->setGraphicsEffect(button_shadow());
+  button_reset_zoom->setGraphicsEffect(button_shadow());
+
+  // chart settings
+
+  chart->setTheme(QChart::ChartThemeLight);
+  chart->setAcceptHoverEvents(true);
+  chart->legend()->setAlignment(Qt::AlignRight);
+  chart->setTitle("Net Balance Projection");
+
+  chart_view->setChart(chart);
+  chart_view->setRenderHint(QPainter::Antialiasing);
+  chart_view->setRubberBand(QChartView::RectangleRubberBand);
+
+  // signals
+
+  connect(button_reset_zoom, &QPushButton::clicked, this, [&]() { chart->zoomReset(); });
+  connect(button_run, &QPushButton::clicked, this, [&]() { run(); });
+}
+
+PortfolioProjection::~PortfolioProjection() {
+  // the running simulation stops at the end of its current batch
+
+  ++(*generation);
+}
+
+void PortfolioProjection::process(const QVector<TableFund const*>& tables) {
+  this->tables = tables;
+
+  // a simulation of the old tables would only be discarded
+
+  ++(*generation);
+
+  pending = true;
+
+  if (isVisible()) {
+    run();
+  }
+}
+
+void PortfolioProjection::showEvent(QShowEvent* event) {
+  QWidget::showEvent(event);
+
+  if (pending) {
+    run();
+  }
+}
+
+void PortfolioProjection::run() {
+  const int job_generation = ++(*generation);
+
+  pending = false;
+
+  clear_chart(chart);
+
+  label_progress->setText("Paths: 0");
+
+  QVector<FundSeries const*> funds;
+
+  int last_month = 0;
+
+  for (auto& table : tables) {
+    if (!table->series.empty()) {
+      funds.append(&table->series);
+
+      last_month = std::max(last_month, table->series.months.last());
+    }
+  }
+
+  if (funds.empty()) {
+    return;
+  }
+
+  // the history is read here. The worker thread gets only copies of it
+
+  const auto [returns, initial_balance] = weighted_returns(funds);
+
+  ProjectionSettings settings;
+
+  settings.months = spinbox_months->value();
+  settings.paths = spinbox_paths->value();
+  settings.block_length = spinbox_block_length->value();
+  settings.deposit = doublespinbox_deposit->value();
+  settings.withdrawal = doublespinbox_withdrawal->value();
+
+  QVector<int> months;
+
+  for (int n = 0; n <= settings.months; n++) {
+    months.append(last_month + n);
+  }
+
+  const auto dates = months_to_dates(months);
+
+  // The batches are reported through the future. The watcher is owned by this widget, so nothing is delivered to it
+  // after it is destroyed and the worker thread never touches the widget
+
+  QFutureInterface<ProjectionResult> future_interface;
+
+  auto* watcher = new QFutureWatcher<ProjectionResult>(this);
+
+  connect(watcher, &QFutureWatcherBase::resultReadyAt, this, [=](int index) {
+    if (job_generation == *generation) {
+      show_result(watcher->resultAt(index), dates, settings.paths);
+    }
+  });
+
+  connect(watcher, &QFutureWatcherBase::finished, watcher, &QObject::deleteLater);
+
+  future_interface.reportStarted();
+
+  watcher->setFuture(future_interface.future());
+
+  QtConcurrent::run([future_interface, job_generation, settings, returns = returns, initial_balance = initial_balance,
+                     generation = generation]() mutable {
+    int index = 0;
+
+    project_balance(returns, initial_balance, settings, [&](const ProjectionResult& result) {
+      if (job_generation != *generation) {
+        return false;
+      }
+
+      future_interface.reportResult(result, index++);
+
+      return true;
+    });
+
+    future_interface.reportFinished();
+  });
+}
+
+void PortfolioProjection::show_result(const ProjectionResult& result, const QVector<int>& dates, const int& total_paths) {
+  label_progress->setText(QString("Paths: %1 / %2").arg(result.paths).arg(total_paths));
+
+  // The whole chart is rebuilt. There are only a few hundred points and about 20 updates
+
+  clear_chart(chart);
+
+  add_axes_to_chart(chart, "Net Balance");
+
+  for (size_t n = 0; n < ProjectionResult::levels.size(); n++) {
+    const auto name = QString("P%1").arg(ProjectionResult::levels[n]);
+
+    auto s = add_series_to_chart(chart, dates, result.percentiles[n], name);
+
+    connect(s, &QLineSeries::hovered, this, [=](const QPointF& point, bool state) {
+      if (state) {
+        auto qdt = QDateTime();
+
+        qdt.setMSecsSinceEpoch(point.x());
+
+        callout->setText(QString("Percentile: %1\nDate: %2\nNet Balance: %3")
+                             .arg(name, qdt.toString("MM/yyyy"), QString::number(point.y(), 'f', 2)));
+
+        callout->setAnchor(point);
+
+        callout->setZValue(11);
+
+        callout->updateGeometry();
+
+        callout->show();
+      } else {
+        callout->hide();
+      }
+    });
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef PORTFOLIO_PROJECTION_HPP
+#define PORTFOLIO_PROJECTION_HPP
+
+#include <QSqlDatabase>
+#include <atomic>
+#include <memory>
+#include "callout.hpp"
+#include "projection.hpp"
+#include "table_fund.hpp"
+#include "ui_portfolio_projection.h"
+
+/*
+  Percentiles of the future portfolio net balance. The simulation runs on the Qt thread pool and the chart is updated
+  after each batch of paths. It starts when the page is shown after the tables changed or when Run is pressed. Running
+  it again or closing the window stops the previous simulation.
+*/
+
+class PortfolioProjection : public QWidget, protected Ui::PortfolioProjection {
+  Q_OBJECT
+ public:
+  explicit PortfolioProjection(const QSqlDatabase& database, QWidget* parent = nullptr);
+  ~PortfolioProjection() override;
+
+  void process(const QVector<TableFund const*>& tables);
+
+ private:
+  QSqlDatabase db;
+
+  QChart* const chart;
+
+  Callout* const callout;
+
+  QVector<TableFund const*> tables;
+
+  // the tables changed while the page was hidden
+
+  bool pending = false;
+
+  // shared with the worker thread. It may outlive the widget while a simulation is finishing
+
+  std::shared_ptr<std::atomic<int>> generation;
+
+  void showEvent(QShowEvent* event) override;
+
+  void run();
+
+  void show_result(const ProjectionResult& result, const QVector<int>& dates, const int& total_paths);
+};
+
+#endif
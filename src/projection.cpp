@@ -0,0 +1,246 @@
+#include "projection.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include "series_alignment.hpp"
+
+namespace {
+
+// Paths simulated together by one thread. Their balances are updated in loops the compiler can vectorize
+
+constexpr int chunk_size = 256;
+
+/*
+  The balances of each month are counted in a histogram with logarithmic bins instead of being stored. Its size does
+  not depend on the number of paths and the histograms of different threads are merged by adding them. Bin 0 counts
+  the balances below the lowest bin. The bin width gives a relative resolution of about 0.6%.
+*/
+
+constexpr int n_bins = 2048;
+
+struct Histogram {
+  double log_min = 0.0;
+  double bins_per_log = 1.0;
+
+  [[nodiscard]] auto bin(const double& balance) const -> int {
+    if (!(balance > 0.0)) {
+      return 0;
+    }
+
+    const double position = (std::log(balance) - log_min) * bins_per_log;
+
+    return (position < 0.0) ? 0 : std::min(static_cast<int>(position) + 1, n_bins - 1);
+  }
+
+  [[nodiscard]] auto value(const int& bin, const double& fraction) const -> double {
+    return (bin == 0) ? 0.0 : std::exp(log_min + (bin - 1 + fraction) / bins_per_log);
+  }
+};
+
+void simulate_chunk(const int& chunk,
+                    const int& n_paths,
+                    const QVector<double>& factors,
+                    const double& initial_balance,
+                    const ProjectionSettings& settings,
+                    const Histogram& histogram,
+                    int* counts) {
+  // Each chunk has its own random number stream. The results are the same whatever thread simulates it
+
+  std::seed_seq seed{static_cast<quint32>(settings.seed), static_cast<quint32>(settings.seed >> 32U),
+                     static_cast<quint32>(chunk)};
+
+  std::mt19937_64 rng(seed);
+
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> random_month(0, factors.size() - 1);
+
+  const double restart_probability = 1.0 / std::max(settings.block_length, 1.0);
+  const double net_deposit = settings.deposit - settings.withdrawal;
+  const int last_month = factors.size() - 1;
+
+  std::array<double, chunk_size> balance{};
+  std::array<int, chunk_size> month{};
+
+  for (int p = 0; p < n_paths; p++) {
+    balance[p] = initial_balance;
+    month[p] = random_month(rng);
+  }
+
+  for (int m = 0; m < settings.months; m++) {
+    // a new block starts with probability 1 / block_length. Otherwise the block continues with the next month
+
+    if (m > 0) {
+      for (int p = 0; p < n_paths; p++) {
+        if (uniform(rng) < restart_probability) {
+          month[p] = random_month(rng);
+        } else {
+          month[p] = (month[p] == last_month) ? 0 : month[p] + 1;
+        }
+      }
+    }
+
+    for (int p = 0; p < n_paths; p++) {
+      balance[p] = std::max(balance[p] + net_deposit, 0.0) * factors[month[p]];
+    }
+
+    int* row = counts + static_cast<ptrdiff_t>(m) * n_bins;
+
+    for (int p = 0; p < n_paths; p++) {
+      row[histogram.bin(balance[p])]++;
+    }
+  }
+}
+
+void update_percentiles(ProjectionResult& result, const QVector<int>& counts, const Histogram& histogram) {
+  const int n_months = result.percentiles[0].size() - 1;
+
+  for (int m = 0; m < n_months; m++) {
+    const int* row = counts.constData() + static_cast<ptrdiff_t>(m) * n_bins;
+
+    double cumulative = 0.0;
+
+    size_t level = 0;
+
+    for (int b = 0; b < n_bins && level < ProjectionResult::levels.size(); b++) {
+      const double next = cumulative + row[b];
+
+      while (level < ProjectionResult::levels.size()) {
+        const double target = ProjectionResult::levels[level] * 0.01 * result.paths;
+
+        if (target > next || row[b] == 0) {
+          break;
+        }
+
+        result.percentiles[level][m + 1] = histogram.value(b, (target - cumulative) / row[b]);
+
+        level++;
+      }
+
+      cumulative = next;
+    }
+  }
+}
+
+}  // namespace
+
+auto weighted_returns(const QVector<FundSeries const*>& funds) -> std::pair<QVector<double>, double> {
+  const auto aligned = align_series(funds, &FundSeries::net_return_perc, 0);
+
+  QVector<double> weights;
+
+  double balance = 0.0;
+
+  for (auto& fund : funds) {
+    const double value = fund->empty() ? 0.0 : std::max(fund->net_balance.last(), 0.0);
+
+    weights.append(value);
+
+    balance += value;
+  }
+
+  // without a positive balance every investment has the same weight
+
+  if (balance <= 0.0) {
+    weights.fill(1.0);
+  }
+
+  const double weights_sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+  QVector<double> returns(aligned.months.size(), 0.0);
+
+  for (int n = 0; n < returns.size(); n++) {
+    const auto count = aligned.mask.row(n).count();
+
+    if (count == 0 || weights_sum <= 0.0) {
+      continue;
+    }
+
+    const double avg = aligned.mask.row(n).select(aligned.values.row(n).array(), 0.0).sum() / count;
+
+    double value = 0.0;
+
+    for (int m = 0; m < funds.size(); m++) {
+      value += weights[m] * (aligned.mask(n, m) ? aligned.values(n, m) : avg);
+    }
+
+    returns[n] = value / weights_sum;
+  }
+
+  return {returns, balance};
+}
+
+auto project_balance(const QVector<double>& returns,
+                     const double& initial_balance,
+                     const ProjectionSettings& settings,
+                     const std::function<bool(const ProjectionResult&)>& progress) -> ProjectionResult {
+  ProjectionResult result;
+
+  const int n_months = std::max(settings.months, 0);
+
+  for (auto& percentile : result.percentiles) {
+    percentile = QVector<double>(n_months + 1, initial_balance);
+  }
+
+  if (returns.empty() || n_months == 0 || settings.paths <= 0) {
+    return result;
+  }
+
+  QVector<double> factors;
+
+  for (const auto& value : returns) {
+    factors.append(std::max(value * 0.01 + 1.0, 0.0));
+  }
+
+  // The bins go from 1/10000 to 1000 times the balance expected without any return
+
+  const double scale = std::max(initial_balance + n_months * std::max(settings.deposit, 0.0), 1.0);
+
+  Histogram histogram;
+
+  histogram.log_min = std::log(scale * 1e-4);
+  histogram.bins_per_log = (n_bins - 1) / (std::log(scale * 1e3) - histogram.log_min);
+
+  QVector<int> counts(n_months * n_bins, 0);
+
+  const int n_chunks = (settings.paths + chunk_size - 1) / chunk_size;
+
+  // about 20 updates. Batches are not made too small so all the threads have work
+
+  const int chunks_per_batch = std::max(n_chunks / 20, 64);
+
+  int* counts_data = counts.data();
+
+  for (int first = 0; first < n_chunks; first += chunks_per_batch) {
+    const int last = std::min(first + chunks_per_batch, n_chunks);
+
+#pragma omp parallel
+    {
+      QVector<int> local_counts(counts.size(), 0);
+
+      int* local_data = local_counts.data();
+
+#pragma omp for schedule(dynamic)
+      for (int chunk = first; chunk < last; chunk++) {
+        const int n_paths = std::min(chunk_size, settings.paths - chunk * chunk_size);
+
+        simulate_chunk(chunk, n_paths, factors, initial_balance, settings, histogram, local_data);
+      }
+
+#pragma omp critical
+      for (int n = 0; n < local_counts.size(); n++) {
+        counts_data[n] += local_data[n];
+      }
+    }
+
+    result.paths = std::min(last * chunk_size, settings.paths);
+
+    update_percentiles(result, counts, histogram);
+
+    if (progress && !progress(result)) {
+      break;
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,59 @@
+#ifndef PROJECTION_HPP
+#define PROJECTION_HPP
+
+#include <QVector>
+#include <array>
+#include <functional>
+#include "fund_series.hpp"
+
+/*
+  Monte Carlo projection of the portfolio net balance. The future monthly returns are drawn from the history with the
+  stationary bootstrap https://en.wikipedia.org/wiki/Bootstrapping_(statistics)#Block_bootstrap
+  Whole months are drawn so the returns of different investments in the same month stay together and their
+  correlation is preserved. Blocks of consecutive months with random length keep part of the autocorrelation.
+*/
+
+struct ProjectionSettings {
+  int months = 120;
+  int paths = 100000;
+
+  double block_length = 12.0;  // mean length in months of the blocks drawn from the history
+
+  // monthly plan applied before the return of each month
+
+  double deposit = 0.0;
+  double withdrawal = 0.0;
+
+  quint64 seed = 1;
+};
+
+struct ProjectionResult {
+  static constexpr std::array<double, 5> levels = {5.0, 25.0, 50.0, 75.0, 95.0};
+
+  int paths = 0;  // paths already simulated
+
+  // one vector per percentile level. Index 0 is the current balance and index n the balance after n months
+
+  std::array<QVector<double>, levels.size()> percentiles;
+};
+
+/*
+  Monthly returns of the investments weighted by their current net balance. Months missing in an investment use the
+  average return of the other investments in that month. Using fixed weights is the same as rebalancing the portfolio
+  every month. Returns the weighted returns in percent and the current balance.
+*/
+
+auto weighted_returns(const QVector<FundSeries const*>& funds) -> std::pair<QVector<double>, double>;
+
+/*
+  The paths are simulated in batches on all cores. After each batch the percentiles of all the paths simulated so far
+  are passed to "progress". The simulation stops early if it returns false. The results do not depend on the number of
+  threads.
+*/
+
+auto project_balance(const QVector<double>& returns,
+                     const double& initial_balance,
+                     const ProjectionSettings& settings,
+                     const std::function<bool(const ProjectionResult&)>& progress = nullptr) -> ProjectionResult;
+
+#endif
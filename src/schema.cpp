@@ -0,0 +1,187 @@
+#include "schema.hpp"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include "database.hpp"
+#include "fund_series.hpp"
+
+namespace {
+
+auto exec_query(const QSqlDatabase& db, const QString& statement) -> bool {
+  auto query = QSqlQuery(db);
+
+  query.prepare(statement);
+
+  if (!query.exec()) {
+    qDebug() << query.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+void create_metadata_tables(const QSqlDatabase& db) {
+  exec_query(db, "create table if not exists funds (id integer primary key, name text unique not null, type int)");
+
+  exec_query(db, "create table if not exists calculation_hashes (name text primary key, hash blob)");
+}
+
+auto create_fund_table(const QSqlDatabase& db, const QString& name, const bool& if_not_exists) -> bool {
+  QString columns;
+
+  for (const auto& column : FundSeries::columns) {
+    columns += QString(", ") + column.first + " real default 0.0";
+  }
+
+  return exec_query(db, QString("create table ") + (if_not_exists ? "if not exists " : "") + name +
+                            " (id integer primary key, date int default (cast(strftime('%s','now') as int))" +
+                            columns + ")");
+}
+
+auto create_benchmark_table(const QSqlDatabase& db, const QString& name, const bool& if_not_exists) -> bool {
+  return exec_query(db, QString("create table ") + (if_not_exists ? "if not exists " : "") + name +
+                            " (id integer primary key, date int default (cast(strftime('%s','now') as int)),"
+                            " value real default 0.0, accumulated real default 0.0)");
+}
+
+auto create_portfolio_table(const QSqlDatabase& db) -> bool {
+  if (!create_fund_table(db, "portfolio", true)) {
+    return false;
+  }
+
+  // One row per month. Older databases may have duplicated dates that have to be removed before creating the index
+
+  return exec_query(db, "delete from portfolio where id not in (select max(id) from portfolio group by date)") &&
+         exec_query(db, "create unique index if not exists portfolio_date on portfolio (date)");
+}
+
+void migrate_metadata(const QSqlDatabase& db) {
+  auto query = QSqlQuery(db);
+
+  query.prepare("select count(*) from funds");
+
+  if (!query.exec() || !query.next() || query.value(0).toInt() > 0) {
+    return;
+  }
+
+  query.prepare("select name from sqlite_master where type='table' order by name");
+
+  if (!query.exec()) {
+    qDebug() << query.lastError().text().toUtf8();
+
+    return;
+  }
+
+  QVector<QString> names;
+
+  while (query.next()) {
+    const auto name = query.value(0).toString();
+
+    if (name != "portfolio" && name != "inflation" && name != "funds" && name != "calculation_hashes") {
+      names.append(name);
+    }
+  }
+
+  // Benchmark tables have 4 columns. The column count is taken from the table schema without reading its rows
+
+  for (auto& name : names) {
+    const auto type = (db.record(name).count() == 4) ? TableType::Benchmark : TableType::Investment;
+
+    register_table(db, name, type);
+  }
+}
+
+auto load_table_names(const QSqlDatabase& db, const TableType& type) -> QVector<QString> {
+  QVector<QString> names;
+
+  auto& query = cached_query(db, "select name from funds where type = ? order by name");
+
+  query.bindValue(0, static_cast<int>(type));
+
+  if (query.exec()) {
+    while (query.next()) {
+      names.append(query.value(0).toString());
+    }
+
+    query.finish();
+  } else {
+    qDebug() << query.lastError().text().toUtf8();
+  }
+
+  return names;
+}
+
+void register_table(const QSqlDatabase& db, const QString& name, const TableType& type) {
+  auto query = QSqlQuery(db);
+
+  // "insert or replace" would delete the row and give the table a new id
+
+  query.prepare("insert into funds (name, type) values (?, ?) on conflict (name) do update set type = excluded.type");
+
+  query.addBindValue(name);
+  query.addBindValue(static_cast<int>(type));
+
+  if (!query.exec()) {
+    qDebug() << query.lastError().text().toUtf8();
+  }
+}
+
+void rename_table_metadata(const QSqlDatabase& db, const QString& name, const QString& new_name) {
+  auto query = QSqlQuery(db);
+
+  for (const auto& table : {"funds", "calculation_hashes"}) {
+    query.prepare(QString("update ") + table + " set name = ? where name = ?");
+
+    query.addBindValue(new_name);
+    query.addBindValue(name);
+
+    if (!query.exec()) {
+      qDebug() << query.lastError().text().toUtf8();
+    }
+  }
+}
+
+void unregister_table(const QSqlDatabase& db, const QString& name) {
+  auto query = QSqlQuery(db);
+
+  for (const auto& table : {"funds", "calculation_hashes"}) {
+    query.prepare(QString("delete from ") + table + " where name = ?");
+
+    query.addBindValue(name);
+
+    if (!query.exec()) {
+      qDebug() << query.lastError().text().toUtf8();
+    }
+  }
+}
+
+auto load_calculation_hash(const QSqlDatabase& db, const QString& name) -> QByteArray {
+  auto& query = cached_query(db, "select hash from calculation_hashes where name = ?");
+
+  query.bindValue(0, name);
+
+  QByteArray hash;
+
+  if (query.exec() && query.next()) {
+    hash = query.value(0).toByteArray();
+  }
+
+  query.finish();
+
+  return hash;
+}
+
+void save_calculation_hash(const QSqlDatabase& db, const QString& name, const QByteArray& hash) {
+  auto& query = cached_query(db, "insert or replace into calculation_hashes (name, hash) values (?, ?)");
+
+  query.bindValue(0, name);
+  query.bindValue(1, hash);
+
+  if (!query.exec()) {
+    qDebug() << query.lastError().text().toUtf8();
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef SCHEMA_HPP
+#define SCHEMA_HPP
+
+#include <QByteArray>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+#include "table_type.hpp"
+
+/*
+  The "funds" table lists the investment and benchmark tables created by the user. It is what the startup reads
+  instead of inspecting every table in the database.
+*/
+
+void create_metadata_tables(const QSqlDatabase& db);
+
+// Tables edited by the user. Investment and portfolio tables have the date plus the FundSeries columns
+
+auto create_fund_table(const QSqlDatabase& db, const QString& name, const bool& if_not_exists = false) -> bool;
+
+auto create_benchmark_table(const QSqlDatabase& db, const QString& name, const bool& if_not_exists = false) -> bool;
+
+// also removes the duplicated months older databases may have before creating the unique date index
+
+auto create_portfolio_table(const QSqlDatabase& db) -> bool;
+
+// fills the "funds" table from the tables found in older databases. Nothing is done if it already has entries
+
+void migrate_metadata(const QSqlDatabase& db);
+
+auto load_table_names(const QSqlDatabase& db, const TableType& type) -> QVector<QString>;
+
+void register_table(const QSqlDatabase& db, const QString& name, const TableType& type);
+
+void rename_table_metadata(const QSqlDatabase& db, const QString& name, const QString& new_name);
+
+void unregister_table(const QSqlDatabase& db, const QString& name);
+
+/*
+  Hashes of the inputs used to calculate the derived columns saved in each table. When the inputs did not change the
+  saved results are used as they are. See calculation_hash() in calculations.hpp
+*/
+
+auto load_calculation_hash(const QSqlDatabase& db, const QString& name) -> QByteArray;
+
+void save_calculation_hash(const QSqlDatabase& db, const QString& name, const QByteArray& hash);
+
+#endif
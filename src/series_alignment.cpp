@@ -0,0 +1,71 @@
+#include "series_alignment.hpp"
+#include <algorithm>
+#include <limits>
+
+auto align_series(const QVector<FundSeries const*>& series, const FundSeries::Column& column, const int& last_n_months)
+    -> AlignedSeries {
+  AlignedSeries output;
+
+  const int n_series = series.size();
+
+  // Merging the sorted month keys of all series in a single pass
+
+  QVector<int> cursors(n_series, 0);
+
+  while (true) {
+    int next = std::numeric_limits<int>::max();
+
+    for (int m = 0; m < n_series; m++) {
+      if (cursors[m] < series[m]->size()) {
+        next = std::min(next, series[m]->months[cursors[m]]);
+      }
+    }
+
+    if (next == std::numeric_limits<int>::max()) {
+      break;
+    }
+
+    output.months.append(next);
+
+    for (int m = 0; m < n_series; m++) {
+      while (cursors[m] < series[m]->size() && series[m]->months[cursors[m]] == next) {
+        cursors[m]++;
+      }
+    }
+  }
+
+  if (last_n_months > 0 && output.months.size() > last_n_months) {
+    output.months.remove(0, output.months.size() - last_n_months);
+  }
+
+  const int n_months = output.months.size();
+
+  output.values = Eigen::MatrixXd::Zero(n_months, n_series);
+  output.mask.setConstant(n_months, n_series, false);
+
+  if (n_months == 0) {
+    return output;
+  }
+
+  // Filling one column at a time. Each series is walked only once starting at the first month of the window
+
+  for (int m = 0; m < n_series; m++) {
+    const auto& s = *series[m];
+    const auto& values = s.*column;
+
+    int idx = static_cast<int>(std::lower_bound(s.months.begin(), s.months.end(), output.months[0]) - s.months.begin());
+
+    for (int n = 0; n < n_months && idx < s.size(); n++) {
+      while (idx < s.size() && s.months[idx] < output.months[n]) {
+        idx++;
+      }
+
+      if (idx < s.size() && s.months[idx] == output.months[n]) {
+        output.values(n, m) = values[idx];
+        output.mask(n, m) = true;
+      }
+    }
+  }
+
+  return output;
+}
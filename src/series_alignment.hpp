@@ -0,0 +1,26 @@
+#ifndef SERIES_ALIGNMENT_HPP
+#define SERIES_ALIGNMENT_HPP
+
+#include <Eigen/Core>
+#include "fund_series.hpp"
+
+/*
+  Dense month x series matrix built from series that do not necessarily have the same months. Row n holds the values
+  of months[n] and column m the values of the m-th input series. Months missing in a series are filled with zero and
+  flagged as false in the mask.
+*/
+
+struct AlignedSeries {
+  QVector<int> months;
+
+  Eigen::MatrixXd values;
+
+  Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> mask;
+};
+
+// Aligns the last n months of the union of the input months. When last_n_months <= 0 all months are used.
+
+auto align_series(const QVector<FundSeries const*>& series, const FundSeries::Column& column, const int& last_n_months)
+    -> AlignedSeries;
+
+#endif
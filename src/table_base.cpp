@@ -1,5 +1,6 @@
 #include "table_base.hpp"
 #include "effects.hpp"
+#include "math.hpp"
 #include "qpushbutton.h"
 #include "table_type.hpp"
 
@@ -74,6 +75,30 @@ void TableBase::set_database(const QSqlDatabase& database) {
   model = new Model(db);
 }
 
+auto TableBase::ensure_loaded() -> bool {
+  if (loaded) {
+    return false;
+  }
+
+  loaded = true;
+
+  init_model();
+
+  return true;
+}
+
+auto TableBase::is_loaded() const -> bool {
+  return loaded;
+}
+
+void TableBase::showEvent(QShowEvent* event) {
+  QWidget::showEvent(event);
+
+  if (ensure_loaded()) {
+    calculate();
+  }
+}
+
 void TableBase::set_chart1_title(const QString& title) {
   chart1->setTitle(title);
 }
@@ -209,10 +234,14 @@ void TableBase::clear_charts() {
 
   for (auto& axis : chart1->axes()) {
     chart1->removeAxis(axis);
+
+    delete axis;
   }
 
   for (auto& axis : chart2->axes()) {
     chart2->removeAxis(axis);
+
+    delete axis;
   }
 }
 
@@ -313,72 +342,67 @@ void TableBase::on_add_row() {
   }
 }
 
-void TableBase::calculate_accumulated_sum(const QString& column_name) {
-  QVector<double> list_values;
-  QVector<double> accu;
-
-  for (int n = 0; n < model->rowCount(); n++) {
-    list_values.append(model->record(n).value(column_name).toDouble());
-  }
+auto TableBase::process_benchmark(const QString& table_name, const int& oldest_date) const
+    -> std::tuple<QVector<int>, QVector<double>, QVector<double>> {
+  const auto benchmark = benchmarks->get(table_name);
 
-  if (!list_values.empty()) {
-    std::reverse(list_values.begin(), list_values.end());
+  const int first = static_cast<int>(std::lower_bound(benchmark.dates.begin(), benchmark.dates.end(), oldest_date) -
+                                     benchmark.dates.begin());
 
-    // cumulative sum
+  QVector<int> dates = benchmark.dates.mid(first);
+  QVector<double> values = benchmark.values.mid(first);
+  QVector<double> accu = values;
 
-    accu.resize(list_values.size());
+  compound_returns(accu);
 
-    std::partial_sum(list_values.begin(), list_values.end(), accu.begin());
-
-    std::reverse(accu.begin(), accu.end());
-
-    for (int n = 0; n < model->rowCount(); n++) {
-      auto rec = model->record(n);
+  return {dates, values, accu};
+}
 
-      rec.setGenerated("accumulated_" + column_name, true);
+void TableBase::update_series(const int& first) {
+  // When first > 0 only the rows from that series index onwards are read again. The model is assumed to have the same
+  // rows it had in the last full update
 
-      rec.setValue("accumulated_" + column_name, accu[n]);
+  if (first <= 0) {
+    // QSqlTableModel fetches the rows lazily. We want all of them in the snapshot
 
-      model->setRecord(n, rec);
+    while (model->canFetchMore()) {
+      model->fetchMore();
     }
-  }
-}
-
-void TableBase::calculate_accumulated_product(const QString& column_name) {
-  QVector<double> list_values;
-  QVector<double> accu;
 
-  for (int n = 0; n < model->rowCount(); n++) {
-    list_values.append(model->record(n).value(column_name).toDouble());
+    series.resize(model->rowCount());
   }
 
-  if (!list_values.empty()) {
-    std::reverse(list_values.begin(), list_values.end());
-
-    for (auto& value : list_values) {
-      value = value * 0.01 + 1.0;
-    }
+  const int n_rows = series.size();
+  const int n_updated = n_rows - std::max(first, 0);
 
-    // cumulative product
+  // The model is sorted in descending order. The series is stored in ascending order
 
-    accu.resize(list_values.size());
+  for (int n = 0; n < n_updated; n++) {
+    const int epoch = model->epoch(n);
 
-    std::partial_sum(list_values.begin(), list_values.end(), accu.begin(), std::multiplies<>());
+    series.dates[n_rows - 1 - n] = epoch;
+    series.months[n_rows - 1 - n] = month_key(epoch);
+  }
 
-    for (auto& value : accu) {
-      value = (value - 1.0) * 100;
-    }
+  for (const auto& [column_name, column] : FundSeries::columns) {
+    const int col = model->fieldIndex(column_name);
 
-    std::reverse(accu.begin(), accu.end());
+    auto& values = series.*column;
 
-    for (int n = 0; n < model->rowCount(); n++) {
-      auto rec = model->record(n);
+    for (int n = 0; n < n_updated; n++) {
+      values[n_rows - 1 - n] = model->data(model->index(n, col)).toDouble();
+    }
+  }
+}
 
-      rec.setGenerated("accumulated_" + column_name, true);
+void TableBase::write_column(const QString& column_name, const int& first) {
+  const int col = model->fieldIndex(column_name);
+  const int n_rows = std::min(model->rowCount(), series.size());
+  const int n_updated = n_rows - std::max(first, 0);
 
-      rec.setValue("accumulated_" + column_name, accu[n]);
+  const auto& values = series.*FundSeries::column(column_name);
 
-      model->setRecord(n, rec);
-    }
+  for (int n = 0; n < n_updated; n++) {
+    model->set_value(n, col, values[n_rows - 1 - n]);
   }
-}
+}
\ No newline at end of file
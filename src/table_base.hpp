@@ -7,7 +7,9 @@
 #include <QSqlTableModel>
 #include <QTableView>
 #include <QtCharts>
+#include "benchmark_cache.hpp"
 #include "callout.hpp"
+#include "fund_series.hpp"
 #include "model.hpp"
 #include "table_type.hpp"
 #include "ui_table_base.h"
@@ -21,6 +23,14 @@ class TableBase : public QWidget, protected Ui::TableBase {
   TableType type;
   Model* model;
 
+  // snapshot of the model used by the calculations and charts. Only investment and portfolio tables fill it
+
+  FundSeries series;
+
+  // shared by all tables. Set by the main window
+
+  BenchmarkCache* benchmarks = nullptr;
+
   void set_database(const QSqlDatabase& database);
   void set_chart1_title(const QString& title);
   void set_chart2_title(const QString& title);
@@ -28,6 +38,17 @@ class TableBase : public QWidget, protected Ui::TableBase {
 
   virtual void init_model() = 0;
 
+  // Tables are loaded lazily. The model is selected the first time the table is shown or its data is needed. Returns
+  // true if the model had to be loaded in this call
+
+  auto ensure_loaded() -> bool;
+
+  [[nodiscard]] auto is_loaded() const -> bool;
+
+  // recalculates the derived columns and the charts. Called after the model is loaded for the first time
+
+  virtual void calculate() {}
+
  signals:
   void hideProgressBar();
   void newChartMouseHover(const QPointF& point);
@@ -42,10 +63,14 @@ class TableBase : public QWidget, protected Ui::TableBase {
   Callout* const callout2;
 
   auto eventFilter(QObject* object, QEvent* event) -> bool override;
+  void showEvent(QShowEvent* event) override;
   void remove_selected_rows();
   void reset_zoom();
-  void calculate_accumulated_sum(const QString& column_name);
-  void calculate_accumulated_product(const QString& column_name);
+  [[nodiscard]] auto process_benchmark(const QString& table_name, const int& oldest_date) const
+      -> std::tuple<QVector<int>, QVector<double>, QVector<double>>;
+
+  void update_series(const int& first = 0);
+  void write_column(const QString& column_name, const int& first = 0);
 
   static void on_chart_mouse_hover(const QPointF& point, bool state, Callout* c, const QString& name);
   void on_chart_selection(const bool& state);
@@ -53,6 +78,8 @@ class TableBase : public QWidget, protected Ui::TableBase {
  private:
   QLocale locale;
 
+  bool loaded = false;
+
   void on_add_row();
 };
 
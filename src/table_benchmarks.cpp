@@ -1,6 +1,7 @@
 #include "table_benchmarks.hpp"
 #include <QSqlQuery>
 #include "chart_funcs.hpp"
+#include "math.hpp"
 
 TableBenchmarks::TableBenchmarks(QWidget* parent) : TableBase(parent) {
   type = TableType::Benchmark;
@@ -35,23 +36,11 @@ void TableBenchmarks::calculate() {
   }
 
   if (!list_values.empty()) {
-    std::reverse(list_values.begin(), list_values.end());
+    // the model rows go from the newest to the oldest month
 
-    for (auto& value : list_values) {
-      value = value * 0.01 + 1.0;
-    }
-
-    // cumulative product
+    accu = list_values;
 
-    accu.resize(list_values.size());
-
-    std::partial_sum(list_values.begin(), list_values.end(), accu.begin(), std::multiplies<>());
-
-    for (auto& value : accu) {
-      value = (value - 1.0) * 100;
-    }
-
-    std::reverse(accu.begin(), accu.end());
+    compound_returns(accu.rbegin(), accu.rend());
 
     for (int n = 0; n < model->rowCount(); n++) {
       auto rec = model->record(n);
@@ -89,10 +78,15 @@ void TableBenchmarks::show_chart() {
 
   auto query = QSqlQuery(db);
 
-  query.prepare("select distinct date,value from " + name + " order by date desc");
+  // the newest months are selected first and then read from the oldest to the newest
+
+  query.prepare("select date,value from (select distinct date,value from " + name +
+                " order by date desc limit ?) order by date asc");
+
+  query.addBindValue(spinbox_months->value());
 
   if (query.exec()) {
-    while (query.next() && dates.size() < spinbox_months->value()) {
+    while (query.next()) {
       dates.append(query.value(0).toInt());
       values.append(query.value(1).toDouble());
     }
@@ -105,22 +99,9 @@ void TableBenchmarks::show_chart() {
     return;
   }
 
-  std::reverse(dates.begin(), dates.end());
-  std::reverse(values.begin(), values.end());
-
-  for (auto& v : values) {
-    v = v * 0.01 + 1.0;
-  }
-
-  // cumulative product
+  accu = values;
 
-  accu.resize(values.size());
-
-  std::partial_sum(values.begin(), values.end(), accu.begin(), std::multiplies<>());
-
-  for (auto& v : accu) {
-    v = (v - 1.0) * 100;
-  }
+  compound_returns(accu);
 
   auto s2 = add_series_to_chart(chart2, dates, accu, "Accumulated");
 
@@ -2,6 +2,54 @@
 #include <QSqlQuery>
 #include "chart_funcs.hpp"
 #include "effects.hpp"
+#include "math.hpp"
+#include "schema.hpp"
+
+namespace {
+
+auto return_points(const FundSeries& series, const int& months) -> std::array<QVector<QPointF>, 2> {
+  const int first = series.window_start(months);
+
+  const QVector<int> dates = series.dates.mid(first);
+
+  QVector<double> accumulated_net_return = series.net_return_perc.mid(first);
+  QVector<double> accumulated_real_return = series.real_return_perc.mid(first);
+
+  compound_returns(accumulated_net_return);
+  compound_returns(accumulated_real_return);
+
+  return {dates_to_points(dates, accumulated_net_return), dates_to_points(dates, accumulated_real_return)};
+}
+
+}  // namespace
+
+void run_fund_job(FundJob& job) {
+  calculate_fund(job.calculation);
+
+  if (job.read_series) {
+    return;
+  }
+
+  const auto& series = job.calculation.series;
+
+  const std::array<FundSeries::Column, 3> columns = {&FundSeries::net_deposit, &FundSeries::net_balance,
+                                                     &FundSeries::accumulated_net_return};
+
+  for (size_t k = 0; k < columns.size(); k++) {
+    const auto& values = series.*columns[k];
+
+    job.balance_points[k] = dates_to_points(series.dates, values);
+
+    if (!values.empty()) {
+      const auto [vmin, vmax] = std::minmax_element(values.begin(), values.end());
+
+      job.balance_min = (k == 0) ? *vmin : std::min(job.balance_min, *vmin);
+      job.balance_max = (k == 0) ? *vmax : std::max(job.balance_max, *vmax);
+    }
+  }
+
+  job.return_points = return_points(series, job.chart_months);
+}
 
 TableFund::TableFund(QWidget* parent) : TableBase(parent) {
   type = TableType::Investment;
@@ -14,7 +62,7 @@ TableFund::TableFund(QWidget* parent) : TableBase(parent) {
 
   connect(spinbox_months, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) {
     clear_chart(chart2);
-    make_chart2();
+    make_chart2(return_points(series, value));
   });
 }
 
@@ -43,6 +91,10 @@ void TableFund::init_model() {
 
   model->select();
 
+  update_series();
+
+  calculated = false;
+
   table_view->setModel(model);
   table_view->setColumnHidden(0, true);
 
@@ -67,139 +119,162 @@ void TableFund::init_model() {
   });
 }
 
-auto TableFund::process_benchmark(const QString& table_name, const int& oldest_date) const
-    -> std::tuple<QVector<int>, QVector<double>, QVector<double>> {
-  QVector<int> dates;
-  QVector<double> values;
-  QVector<double> accu;
+void TableFund::calculate() {
+  auto job = prepare_calculation();
+
+  if (job) {
+    if (job->reuse_saved) {
+      job->calculation.saved_hash = load_calculation_hash(db, name);
+    }
+
+    run_fund_job(*job);
 
-  auto query = QSqlQuery(db);
+    apply_calculation(*job);
+  }
+}
+
+auto TableFund::prepare_calculation() -> std::optional<FundJob> {
+  qsettings.beginGroup(name);
+
+  double income_tax = qsettings.value("income_tax", 0.0).toDouble();
 
-  query.prepare("select distinct date,value from " + table_name + " where date >= ? order by date");
+  qsettings.endGroup();
 
-  query.addBindValue(oldest_date);
+  // A table that was not shown yet can not have edits. The job reads its rows and nothing is fetched here
 
-  if (query.exec()) {
-    while (query.next()) {
-      dates.append(query.value(0).toInt());
-      values.append(query.value(1).toDouble());
+  if (!is_loaded()) {
+    if (calculated && !calculation_pending && income_tax == calculated_income_tax &&
+        benchmarks->revision() == calculated_benchmarks_revision) {
+      return {};
     }
-  } else {
-    qDebug("Failed to get inflation table values!");
-  }
 
-  for (auto& v : values) {
-    v = v * 0.01 + 1.0;
-  }
+    calculation_pending = true;
 
-  // cumulative product
+    calculated_income_tax = income_tax;
+    calculated_benchmarks_revision = benchmarks->revision();
 
-  accu.resize(values.size());
+    FundJob job;
 
-  std::partial_sum(values.begin(), values.end(), accu.begin(), std::multiplies<>());
+    job.name = name;
+    job.calculation = FundCalculation{{}, benchmarks->get("inflation"), income_tax, 0, ++calculation_id};
+    job.read_series = true;
+    job.reuse_saved = true;
 
-  for (auto& v : accu) {
-    v = (v - 1.0) * 100;
+    return job;
   }
 
-  for (auto& v : values) {
-    v = (v - 1.0) * 100;
-  }
+  const int dirty_row = model->take_dirty_row();
 
-  return {dates, values, accu};
-}
+  // The edits taken by a calculation that is still running are lost if its results are discarded
 
-void TableFund::calculate() {
-  if (model->rowCount() == 0) {
-    return;
+  const bool full_update = !calculated || calculation_pending || dirty_row >= model->rowCount() ||
+                           series.size() != model->rowCount() || income_tax != calculated_income_tax ||
+                           benchmarks->revision() != calculated_benchmarks_revision;
+
+  if (!full_update && dirty_row < 0) {
+    return {};
   }
 
-  // Tables are displayed in descending order. This is also the order the data has to be retrieved from the model
+  if (full_update) {
+    chart1_series.clear();
+  }
 
-  QString oldest_investment_date = model->record(model->rowCount() - 1).value("date").toString();
+  // series index of the oldest edited row. Everything before it is still valid
 
-  auto qdt = QDateTime::fromString(oldest_investment_date, "MM/yyyy");
+  const int first = full_update ? 0 : series.size() - 1 - dirty_row;
 
-  auto [inflation_dates, inflation_values, inflation_accumulated] =
-      process_benchmark("inflation", qdt.toSecsSinceEpoch());
+  update_series(first);
 
-  qsettings.beginGroup(name);
+  if (series.empty()) {
+    return {};
+  }
 
-  double income_tax = qsettings.value("income_tax", 0.0).toDouble();
+  calculation_pending = true;
 
-  qsettings.endGroup();
+  calculated_income_tax = income_tax;
+  calculated_benchmarks_revision = benchmarks->revision();
 
-  calculate_accumulated_sum("deposit");
-  calculate_accumulated_sum("withdrawal");
+  FundJob job;
 
-  double gross_return_sum = 0.0;
+  job.name = name;
+  job.calculation = FundCalculation{series, benchmarks->get("inflation"), income_tax, first, ++calculation_id};
+  job.chart_months = spinbox_months->value();
 
-  for (int n = model->rowCount() - 1; n >= 0; n--) {
-    QString date = model->record(n).value("date").toString();
-    double deposit = model->record(n).value("deposit").toDouble();
-    double withdrawal = model->record(n).value("withdrawal").toDouble();
-    double starting_balance = model->record(n).value("starting_balance").toDouble();
-    double ending_balance = model->record(n).value("ending_balance").toDouble();
-    double accumulated_deposit = model->record(n).value("accumulated_deposit").toDouble();
-    double accumulated_withdrawal = model->record(n).value("accumulated_withdrawal").toDouble();
+  // the first calculation after loading the table can reuse the results saved in the database
+
+  job.reuse_saved = !calculated && full_update;
+
+  return job;
+}
 
-    double gross_return = ending_balance - starting_balance - deposit + withdrawal;
+void TableFund::apply_calculation(const FundJob& job) {
+  const auto& calculation = job.calculation;
 
-    gross_return_sum += gross_return;
+  if (calculation.id != calculation_id) {
+    return;
+  }
 
-    double net_return = gross_return * (1.0 - 0.01 * income_tax);
+  series = calculation.series;
 
-    double net_return_perc = 100 * net_return / (starting_balance + deposit - withdrawal);
+  last_hash = calculation.hash;
 
-    double real_return_perc = net_return_perc;
+  // The results are kept only in the series until the table is shown. Loading the model calculates it again, and
+  // the saved columns are reused if the hash still matches
 
-    for (int i = 0; i < inflation_dates.size(); i++) {
-      qdt.setSecsSinceEpoch(inflation_dates[i]);
+  if (job.read_series) {
+    calculated = true;
+    calculation_pending = false;
 
-      if (qdt.toString("MM/yyyy") == date) {
-        real_return_perc = 100.0 * (net_return_perc - inflation_values[i]) / (100.0 + inflation_values[i]);
+    return;
+  }
 
-        break;
-      }
+  if (!calculation.up_to_date) {
+    for (const auto& column_name :
+         {"accumulated_deposit", "accumulated_withdrawal", "net_deposit", "net_balance", "net_return",
+          "net_return_perc", "accumulated_net_return", "accumulated_net_return_perc", "real_return_perc",
+          "accumulated_real_return_perc"}) {
+      write_column(column_name, calculation.first);
     }
+  }
 
-    auto rec = model->record(n);
+  calculated = true;
+  calculation_pending = false;
 
-    rec.setGenerated("net_deposit", true);
-    rec.setGenerated("net_return", true);
-    rec.setGenerated("net_return_perc", true);
-    rec.setGenerated("net_balance", true);
-    rec.setGenerated("real_return_perc", true);
+  // the chart points were prepared by run_fund_job(). Here they are only handed to the charts
 
-    rec.setValue("net_deposit", accumulated_deposit - accumulated_withdrawal);
-    rec.setValue("gross_return", gross_return);
-    rec.setValue("net_return", net_return);
-    rec.setValue("net_balance", ending_balance - gross_return_sum * 0.01 * income_tax);
-    rec.setValue("gross_return_perc", 100 * gross_return / (starting_balance + deposit - withdrawal));
-    rec.setValue("net_return_perc", net_return_perc);
-    rec.setValue("real_return_perc", real_return_perc);
+  if (chart1_series.size() != 3 || series_points(chart1_series[0]).size() != job.balance_points[0].size()) {
+    clear_charts();
 
-    model->setRecord(n, rec);
+    make_chart1(job);
+  } else {
+    update_chart1(job);
+
+    clear_chart(chart2);
   }
 
-  calculate_accumulated_sum("net_return");
-  calculate_accumulated_product("net_return_perc");
-  calculate_accumulated_product("real_return_perc");
+  make_chart2(job.return_points);
+}
 
-  clear_charts();
+auto TableFund::results_hash() const -> QByteArray {
+  return calculated ? last_hash : QByteArray();
+}
 
-  make_chart1();
-  make_chart2();
+void TableFund::save_results_hash() {
+  if (calculated) {
+    save_calculation_hash(db, name, last_hash);
+  }
 }
 
-void TableFund::make_chart1() {
+void TableFund::make_chart1(const FundJob& job) {
   chart1->setTitle(name.toUpper());
 
   add_axes_to_chart(chart1, QLocale().currencySymbol());
 
-  auto s1 = add_series_to_chart(chart1, model, "Net Deposit", "net_deposit");
-  auto s2 = add_series_to_chart(chart1, model, "Net Balance", "net_balance");
-  auto s3 = add_series_to_chart(chart1, model, "Net Return", "accumulated_net_return");
+  auto s1 = add_points_to_chart(chart1, job.balance_points[0], "Net Deposit");
+  auto s2 = add_points_to_chart(chart1, job.balance_points[1], "Net Balance");
+  auto s3 = add_points_to_chart(chart1, job.balance_points[2], "Net Return");
+
+  chart1_series = {s1, s2, s3};
 
   connect(s1, &QLineSeries::hovered, this,
           [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout1, s1->name()); });
@@ -209,65 +284,40 @@ void TableFund::make_chart1() {
           [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout1, s3->name()); });
 }
 
-void TableFund::make_chart2() {
-  chart2->setTitle(name.toUpper());
-
-  add_axes_to_chart(chart2, "%");
-
-  QVector<int> dates;
-  QVector<double> net_return;
-  QVector<double> real_return;
-  QVector<double> accumulated_net_return;
-  QVector<double> accumulated_real_return;
-
-  for (int n = 0; n < model->rowCount() && dates.size() < spinbox_months->value(); n++) {
-    auto qdt = QDateTime::fromString(model->record(n).value("date").toString(), "MM/yyyy");
+void TableFund::update_chart1(const FundJob& job) {
+  // same number of points. Only their values changed
 
-    dates.append(qdt.toSecsSinceEpoch());
-    net_return.append(model->record(n).value("net_return_perc").toDouble());
-    real_return.append(model->record(n).value("real_return_perc").toDouble());
+  for (size_t k = 0; k < chart1_series.size(); k++) {
+    set_series_points(chart1_series[k], job.balance_points[k]);
   }
 
-  if (dates.empty()) {
-    return;
-  }
-
-  std::reverse(net_return.begin(), net_return.end());
-  std::reverse(real_return.begin(), real_return.end());
+  auto* axis_y = dynamic_cast<QValueAxis*>(chart1->axes(Qt::Vertical)[0]);
 
-  for (auto& value : net_return) {
-    value = value * 0.01 + 1.0;
-  }
+  if (job.balance_min < axis_y->min() || job.balance_max > axis_y->max()) {
+    const double vmin = std::min(axis_y->min(), job.balance_min);
+    const double vmax = std::max(axis_y->max(), job.balance_max);
 
-  for (auto& value : real_return) {
-    value = value * 0.01 + 1.0;
+    axis_y->setRange(vmin - 0.05 * fabs(vmin), vmax + 0.05 * fabs(vmax));
   }
+}
 
-  accumulated_net_return.resize(net_return.size());
-  accumulated_real_return.resize(real_return.size());
-
-  std::partial_sum(net_return.begin(), net_return.end(), accumulated_net_return.begin(), std::multiplies<>());
-  std::partial_sum(real_return.begin(), real_return.end(), accumulated_real_return.begin(), std::multiplies<>());
+void TableFund::make_chart2(const std::array<QVector<QPointF>, 2>& points) {
+  chart2->setTitle(name.toUpper());
 
-  for (auto& value : accumulated_net_return) {
-    value = (value - 1.0) * 100;
-  }
+  add_axes_to_chart(chart2, "%");
 
-  for (auto& value : accumulated_real_return) {
-    value = (value - 1.0) * 100;
+  if (points[0].empty()) {
+    return;
   }
 
-  std::reverse(accumulated_net_return.begin(), accumulated_net_return.end());
-  std::reverse(accumulated_real_return.begin(), accumulated_real_return.end());
-
-  perc_chart_oldest_date = dates[dates.size() - 1];
+  perc_chart_oldest_date = static_cast<int>(points[0].first().x() / 1000);
 
-  auto s1 = add_series_to_chart(chart2, dates, accumulated_net_return, "Net Return");
+  auto s1 = add_points_to_chart(chart2, points[0], "Net Return");
 
   connect(s1, &QLineSeries::hovered, this,
           [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout2, s1->name()); });
 
-  auto s2 = add_series_to_chart(chart2, dates, accumulated_real_return, "Real Return");
+  auto s2 = add_points_to_chart(chart2, points[1], "Real Return");
 
   connect(s2, &QLineSeries::hovered, this,
           [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout2, s2->name()); });
@@ -284,43 +334,10 @@ void TableFund::show_benchmark(const TableBase* btable) {
     return;
   }
 
-  auto series = new QLineSeries();
+  // the benchmark should not change the time window chosen for the investment
 
-  series->setName(btable->name.toLower());
+  auto series = add_points_to_chart(chart2, dates_to_points(dates, accumulated), btable->name, false);
 
   connect(series, &QLineSeries::hovered, this,
           [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout2, series->name()); });
-
-  double vmin = dynamic_cast<QValueAxis*>(chart2->axes(Qt::Vertical)[0])->min();
-  double vmax = dynamic_cast<QValueAxis*>(chart2->axes(Qt::Vertical)[0])->max();
-
-  for (int n = 0; n < dates.size(); n++) {
-    auto qdt = QDateTime::fromSecsSinceEpoch(dates[n]);
-
-    auto epoch_in_ms = qdt.toMSecsSinceEpoch();
-
-    double v = accumulated[n];
-
-    if (!chart2->series().empty()) {
-      vmin = std::min(vmin, v);
-      vmax = std::max(vmax, v);
-    } else {
-      if (n == 0) {
-        vmin = v;
-        vmax = v;
-      } else {
-        vmin = std::min(vmin, v);
-        vmax = std::max(vmax, v);
-      }
-    }
-
-    series->append(epoch_in_ms, v);
-  }
-
-  chart2->addSeries(series);
-
-  series->attachAxis(chart2->axes(Qt::Horizontal)[0]);
-  series->attachAxis(chart2->axes(Qt::Vertical)[0]);
-
-  chart2->axes(Qt::Vertical)[0]->setRange(vmin - 0.05 * fabs(vmin), vmax + 0.05 * fabs(vmax));
 }
\ No newline at end of file
@@ -1,8 +1,45 @@
 #ifndef TABLE_FUND_HPP
 #define TABLE_FUND_HPP
 
+#include <array>
+#include <optional>
+#include "calculations.hpp"
 #include "table_base.hpp"
 
+/*
+  Calculation of one investment table. prepare_calculation() fills the inputs on the GUI thread. run_fund_job() does
+  the calculation, the hashing and builds the chart points. It can be called from any thread. apply_calculation() hands
+  the results to the model and to the charts on the GUI thread.
+*/
+
+struct FundJob {
+  QString name;
+
+  FundCalculation calculation;
+
+  // The table model was not loaded yet. The series has to be read from the database before run_fund_job(). Only the
+  // series is calculated. The model and the charts are left for when the table is shown
+
+  bool read_series = false;
+
+  // The hash saved in the database has to be read before run_fund_job() and set in calculation.saved_hash. The saved
+  // derived columns are reused if it matches
+
+  bool reuse_saved = false;
+
+  int chart_months = 0;  // time window of chart 2
+
+  // outputs
+
+  std::array<QVector<QPointF>, 3> balance_points;  // net deposit, net balance and net return
+  std::array<QVector<QPointF>, 2> return_points;   // accumulated net and real returns in the time window
+
+  double balance_min = 0.0;
+  double balance_max = 0.0;
+};
+
+void run_fund_job(FundJob& job);
+
 class TableFund : public TableBase {
   Q_OBJECT
  public:
@@ -11,7 +48,24 @@ class TableFund : public TableBase {
   void show_benchmark(const TableBase* btable);
 
   void init_model() override;
-  void calculate();
+  void calculate() override;
+
+  /*
+    calculate() is split in these two steps so that the run_fund_job() call in between can be done in a worker thread.
+    Both have to be called from the GUI thread. An empty optional means that nothing changed since the last
+    calculation. They do not load the table model. See FundJob::read_series
+  */
+
+  auto prepare_calculation() -> std::optional<FundJob>;
+  void apply_calculation(const FundJob& job);
+
+  // Hash of the inputs of the last calculation applied to the table. Empty if it has not been calculated yet
+
+  [[nodiscard]] auto results_hash() const -> QByteArray;
+
+  // to be called after the table is saved. The next startup will not have to calculate it again
+
+  void save_results_hash();
 
  signals:
   void getBenchmarkTables();
@@ -21,11 +75,21 @@ class TableFund : public TableBase {
 
   int perc_chart_oldest_date = 0;
 
-  [[nodiscard]] auto process_benchmark(const QString& table_name, const int& oldest_date) const
-      -> std::tuple<QVector<int>, QVector<double>, QVector<double>>;
+  // state of the last calculation. It decides if an edit can be recalculated from the edited row onwards
+
+  bool calculated = false;
+  bool calculation_pending = false;
+  int calculation_id = 0;
+
+  QByteArray last_hash;
+  double calculated_income_tax = 0.0;
+  int calculated_benchmarks_revision = 0;
+
+  QVector<QLineSeries*> chart1_series;
 
-  void make_chart1();
-  void make_chart2();
+  void make_chart1(const FundJob& job);
+  void make_chart2(const std::array<QVector<QPointF>, 2>& points);
+  void update_chart1(const FundJob& job);
 };
 
 #endif
\ No newline at end of file
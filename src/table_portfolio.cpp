@@ -2,6 +2,9 @@
 #include <QSqlError>
 #include <QSqlQuery>
 #include "chart_funcs.hpp"
+#include "database.hpp"
+#include "math.hpp"
+#include "schema.hpp"
 
 TablePortfolio::TablePortfolio(QWidget* parent) {
   type = TableType::Portfolio;
@@ -42,158 +45,59 @@ void TablePortfolio::init_model() {
 
   model->select();
 
+  update_series();
+
   table_view->setModel(model);
   table_view->setColumnHidden(0, true);
 }
 
 void TablePortfolio::process_fund_tables(const QVector<TableFund const*>& tables) {
-  // get date values in each investment tables
+  // The saved rows are still valid if every investment has the same results used to build them
 
-  QSet<int> list_set;
+  QVector<QString> names;
+  QVector<QByteArray> hashes;
 
   for (auto& table : tables) {
-    // making sure all the latest data was saved to the database
-
-    table->model->submitAll();
-
-    auto query = QSqlQuery(db);
-
-    query.prepare("select distinct date from " + table->name + " order by date");
-
-    if (query.exec()) {
-      while (query.next()) {
-        list_set.insert(query.value(0).toInt());
-      }
-    } else {
-      qDebug() << table->model->lastError().text().toUtf8();
-    }
+    names.append(table->name);
+    hashes.append(table->results_hash());
   }
 
-  if (list_set.empty()) {
-    return;
-  }
+  const auto hash = portfolio_hash(names, hashes);
 
-  QList<int> list_dates = list_set.values();
-
-  std::sort(list_dates.begin(), list_dates.end());
-
-  // calculate columns
-
-  auto qdt = QDateTime();
-
-  for (auto& date : list_dates) {
-    double deposit = 0.0;
-    double withdrawal = 0.0;
-    double starting_balance = 0.0;
-    double ending_balance = 0.0;
-    double accumulated_deposit = 0.0;
-    double accumulated_withdrawal = 0.0;
-    double net_deposit = 0.0;
-    double net_balance = 0.0;
-    double net_return = 0.0;
-    double accumulated_net_return = 0.0;
-
-    qdt.setSecsSinceEpoch(date);
-
-    QString date_month = qdt.toString("MM/yyyy");
-
-    for (auto& table : tables) {
-      for (int n = 0; n < table->model->rowCount(); n++) {
-        QString tdate = table->model->record(n).value("date").toString();
-
-        if (date_month == tdate) {
-          deposit += table->model->record(n).value("deposit").toDouble();
-          withdrawal += table->model->record(n).value("withdrawal").toDouble();
-          starting_balance += table->model->record(n).value("starting_balance").toDouble();
-          ending_balance += table->model->record(n).value("ending_balance").toDouble();
-          accumulated_deposit += table->model->record(n).value("accumulated_deposit").toDouble();
-          accumulated_withdrawal += table->model->record(n).value("accumulated_withdrawal").toDouble();
-          net_deposit += table->model->record(n).value("net_deposit").toDouble();
-          net_balance += table->model->record(n).value("net_balance").toDouble();
-          net_return += table->model->record(n).value("net_return").toDouble();
-          accumulated_net_return += table->model->record(n).value("accumulated_net_return").toDouble();
-
-          break;
-        }
-      }
+  if (hash.isEmpty() || hash != load_calculation_hash(db, name)) {
+    if (rebuild_table(tables) && !hash.isEmpty()) {
+      save_calculation_hash(db, name, hash);
     }
+  }
 
-    double net_return_perc = 100 * net_return / (starting_balance + deposit - withdrawal);
-
-    double real_return_perc = net_return_perc;
-
-    // get inflation values so we can update real_return_perc
-
-    QVector<int> inflation_dates;
-    QVector<double> inflation_values;
-    QVector<double> inflation_accumulated;
-
-    auto query = QSqlQuery(db);
-
-    query.prepare("select distinct date,value,accumulated from inflation order by date");
+  model->select();
 
-    if (query.exec()) {
-      while (query.next()) {
-        inflation_dates.append(query.value(0).toInt());
-        inflation_values.append(query.value(1).toDouble());
-        inflation_accumulated.append(query.value(2).toDouble());
-      }
-    } else {
-      qDebug("Failed to get inflation table values!");
-    }
+  update_series();
 
-    for (int i = 0; i < inflation_dates.size(); i++) {
-      qdt.setSecsSinceEpoch(inflation_dates[i]);
+  if (!series.empty()) {
+    clear_charts();
 
-      if (qdt.toString("MM/yyyy") == date_month) {
-        real_return_perc = 100.0 * (net_return_perc - inflation_values[i]) / (100.0 + inflation_values[i]);
+    make_chart1();
+    make_chart2();
+  }
+}
 
-        break;
-      }
-    }
+auto TablePortfolio::rebuild_table(const QVector<TableFund const*>& tables) -> bool {
+  QVector<FundSeries const*> funds;
 
-    double accumulated_net_return_perc = 0;
-    double accumulated_real_return_perc = 0;
-
-    query = QSqlQuery(db);
-
-    query.prepare("insert or replace into " + name + " values ((select id from " + name +
-                  " where date == ?),?,?,?,?,?,?,?,?,?,?,?,?,?,?,?)");
-
-    query.addBindValue(date);
-    query.addBindValue(date);
-    query.addBindValue(deposit);
-    query.addBindValue(withdrawal);
-    query.addBindValue(starting_balance);
-    query.addBindValue(ending_balance);
-    query.addBindValue(accumulated_deposit);
-    query.addBindValue(accumulated_withdrawal);
-    query.addBindValue(net_deposit);
-    query.addBindValue(net_balance);
-    query.addBindValue(net_return);
-    query.addBindValue(net_return_perc);
-    query.addBindValue(accumulated_net_return);
-    query.addBindValue(accumulated_net_return_perc);
-    query.addBindValue(real_return_perc);
-    query.addBindValue(accumulated_real_return_perc);
-
-    if (!query.exec()) {
-      qDebug() << model->lastError().text().toUtf8();
-    }
+  for (auto& table : tables) {
+    funds.append(&table->series);
   }
 
-  model->select();
-
-  if (model->rowCount() > 0) {
-    calculate_accumulated_sum("net_return");
-    calculate_accumulated_product("net_return_perc");
-    calculate_accumulated_product("real_return_perc");
+  // used to update real_return_perc
 
-    clear_charts();
+  const auto portfolio = calculate_portfolio(funds, benchmarks->get("inflation"));
 
-    make_chart1();
-    make_chart2();
+  if (portfolio.empty()) {
+    return false;
   }
+
+  return write_fund_series(db, name, portfolio);
 }
 
 void TablePortfolio::make_chart1() {
@@ -201,9 +105,9 @@ void TablePortfolio::make_chart1() {
 
   add_axes_to_chart(chart1, QLocale().currencySymbol());
 
-  auto s1 = add_series_to_chart(chart1, model, "Net Deposit", "net_deposit");
-  auto s2 = add_series_to_chart(chart1, model, "Net Balance", "net_balance");
-  auto s3 = add_series_to_chart(chart1, model, "Net Return", "accumulated_net_return");
+  auto s1 = add_series_to_chart(chart1, series.dates, series.net_deposit, "Net Deposit");
+  auto s2 = add_series_to_chart(chart1, series.dates, series.net_balance, "Net Balance");
+  auto s3 = add_series_to_chart(chart1, series.dates, series.accumulated_net_return, "Net Return");
 
   connect(s1, &QLineSeries::hovered, this,
           [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout1, s1->name()); });
@@ -218,53 +122,21 @@ void TablePortfolio::make_chart2() {
 
   add_axes_to_chart(chart2, "%");
 
-  QVector<int> dates;
-  QVector<double> net_return;
-  QVector<double> real_return;
-  QVector<double> accumulated_net_return;
-  QVector<double> accumulated_real_return;
+  const int first = series.window_start(spinbox_months->value());
 
-  for (int n = 0; n < model->rowCount() && dates.size() < spinbox_months->value(); n++) {
-    auto qdt = QDateTime::fromString(model->record(n).value("date").toString(), "MM/yyyy");
-
-    dates.append(qdt.toSecsSinceEpoch());
-    net_return.append(model->record(n).value("net_return_perc").toDouble());
-    real_return.append(model->record(n).value("real_return_perc").toDouble());
-  }
+  const QVector<int> dates = series.dates.mid(first);
 
   if (dates.empty()) {
     return;
   }
 
-  std::reverse(net_return.begin(), net_return.end());
-  std::reverse(real_return.begin(), real_return.end());
-
-  for (auto& value : net_return) {
-    value = value * 0.01 + 1.0;
-  }
-
-  for (auto& value : real_return) {
-    value = value * 0.01 + 1.0;
-  }
+  QVector<double> accumulated_net_return = series.net_return_perc.mid(first);
+  QVector<double> accumulated_real_return = series.real_return_perc.mid(first);
 
-  accumulated_net_return.resize(net_return.size());
-  accumulated_real_return.resize(real_return.size());
+  compound_returns(accumulated_net_return);
+  compound_returns(accumulated_real_return);
 
-  std::partial_sum(net_return.begin(), net_return.end(), accumulated_net_return.begin(), std::multiplies<>());
-  std::partial_sum(real_return.begin(), real_return.end(), accumulated_real_return.begin(), std::multiplies<>());
-
-  for (auto& value : accumulated_net_return) {
-    value = (value - 1.0) * 100;
-  }
-
-  for (auto& value : accumulated_real_return) {
-    value = (value - 1.0) * 100;
-  }
-
-  std::reverse(accumulated_net_return.begin(), accumulated_net_return.end());
-  std::reverse(accumulated_real_return.begin(), accumulated_real_return.end());
-
-  perc_chart_oldest_date = dates[dates.size() - 1];
+  perc_chart_oldest_date = dates[0];
 
   auto s1 = add_series_to_chart(chart2, dates, accumulated_net_return, "Net Return");
 
@@ -288,85 +160,10 @@ void TablePortfolio::show_benchmark(const TableBenchmarks* btable) {
     return;
   }
 
-  auto series = new QLineSeries();
+  // the benchmark should not change the time window chosen for the investment
 
-  series->setName(btable->name.toLower());
+  auto series = add_points_to_chart(chart2, dates_to_points(dates, accumulated), btable->name, false);
 
   connect(series, &QLineSeries::hovered, this,
           [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout2, series->name()); });
-
-  double vmin = dynamic_cast<QValueAxis*>(chart2->axes(Qt::Vertical)[0])->min();
-  double vmax = dynamic_cast<QValueAxis*>(chart2->axes(Qt::Vertical)[0])->max();
-
-  for (int n = 0; n < dates.size(); n++) {
-    auto qdt = QDateTime::fromSecsSinceEpoch(dates[n]);
-
-    auto epoch_in_ms = qdt.toMSecsSinceEpoch();
-
-    double v = accumulated[n];
-
-    if (!chart2->series().empty()) {
-      vmin = std::min(vmin, v);
-      vmax = std::max(vmax, v);
-    } else {
-      if (n == 0) {
-        vmin = v;
-        vmax = v;
-      } else {
-        vmin = std::min(vmin, v);
-        vmax = std::max(vmax, v);
-      }
-    }
-
-    series->append(epoch_in_ms, v);
-  }
-
-  chart2->addSeries(series);
-
-  series->attachAxis(chart2->axes(Qt::Horizontal)[0]);
-  series->attachAxis(chart2->axes(Qt::Vertical)[0]);
-
-  chart2->axes(Qt::Vertical)[0]->setRange(vmin - 0.05 * fabs(vmin), vmax + 0.05 * fabs(vmax));
-}
-
-auto TablePortfolio::process_benchmark(const QString& table_name, const int& oldest_date) const
-    -> std::tuple<QVector<int>, QVector<double>, QVector<double>> {
-  QVector<int> dates;
-  QVector<double> values;
-  QVector<double> accu;
-
-  auto query = QSqlQuery(db);
-
-  query.prepare("select distinct date,value from " + table_name + " where date >= ? order by date");
-
-  query.addBindValue(oldest_date);
-
-  if (query.exec()) {
-    while (query.next()) {
-      dates.append(query.value(0).toInt());
-      values.append(query.value(1).toDouble());
-    }
-  } else {
-    qDebug("Failed to get inflation table values!");
-  }
-
-  for (auto& v : values) {
-    v = v * 0.01 + 1.0;
-  }
-
-  // cumulative product
-
-  accu.resize(values.size());
-
-  std::partial_sum(values.begin(), values.end(), accu.begin(), std::multiplies<>());
-
-  for (auto& v : accu) {
-    v = (v - 1.0) * 100;
-  }
-
-  for (auto& v : values) {
-    v = (v - 1.0) * 100;
-  }
-
-  return {dates, values, accu};
 }
@@ -20,8 +20,9 @@ class TablePortfolio : public TableBase {
  private:
   int perc_chart_oldest_date = 0;
 
-  [[nodiscard]] auto process_benchmark(const QString& table_name, const int& oldest_date) const
-      -> std::tuple<QVector<int>, QVector<double>, QVector<double>>;
+  // writes the sum of the investment tables to the database. Returns false if nothing was written
+
+  auto rebuild_table(const QVector<TableFund const*>& tables) -> bool;
 
   void make_chart1();
   void make_chart2();
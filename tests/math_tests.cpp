@@ -0,0 +1,159 @@
+#include <QTextStream>
+#include <cmath>
+#include <random>
+#include "math.hpp"
+
+/*
+  Checks of the numerical kernels that do not need a database or the graphical interface. Each check writes its name
+  when it fails and the program returns the number of failures.
+*/
+
+namespace {
+
+int failures = 0;
+
+void check(const bool& condition, const QString& name) {
+  if (!condition) {
+    QTextStream(stderr) << "failed: " << name << "\n";
+
+    failures++;
+  }
+}
+
+// correlation of a and b over the rows where both are valid, calculated one pair at a time
+
+auto overlap_correlation(const Eigen::MatrixXd& data,
+                         const Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic>& mask,
+                         const int& a,
+                         const int& b) -> double {
+  RunningCovariance<double> covariance;
+
+  for (Eigen::Index n = 0; n < data.rows(); n++) {
+    if (mask(n, a) && mask(n, b)) {
+      covariance.add(data(n, a), data(n, b));
+    }
+  }
+
+  return covariance.correlation();
+}
+
+/*
+  Investments that start in different months. The second one exists only in the last quarter of the history and
+  follows the first one closely there. Its correlation has to be the one of the shared months and not be diluted by the
+  months where it has no values.
+*/
+
+void test_correlation_matrix_staggered_start() {
+  const int n_months = 200;
+  const int n_series = 4;
+
+  std::mt19937_64 rng(1);
+
+  std::normal_distribution<double> returns(0.6, 1.5);
+  std::normal_distribution<double> noise(0.0, 0.2);
+
+  Eigen::MatrixXd data = Eigen::MatrixXd::Zero(n_months, n_series);
+  Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> mask(n_months, n_series);
+
+  mask.setConstant(true);
+
+  for (int n = 0; n < n_months; n++) {
+    data(n, 0) = returns(rng);
+    data(n, 1) = (n >= 150) ? data(n, 0) + noise(rng) : 0.0;
+    data(n, 2) = returns(rng);
+    data(n, 3) = (n >= 50) ? -data(n, 0) + 5.0 * noise(rng) : 0.0;
+
+    mask(n, 1) = n >= 150;
+    mask(n, 3) = n >= 50;
+  }
+
+  const Eigen::MatrixXd matrix = correlation_matrix(data, mask);
+
+  check(matrix(0, 1) > 0.98, "staggered pair keeps its correlation");
+
+  for (int a = 0; a < n_series; a++) {
+    check(std::fabs(matrix(a, a) - 1.0) < 1e-12, "unit diagonal");
+
+    for (int b = 0; b < n_series; b++) {
+      const double expected = (a == b) ? 1.0 : overlap_correlation(data, mask, a, b);
+
+      check(std::fabs(matrix(a, b) - expected) < 1e-9,
+            QString("pair %1 %2 matches the one pair calculation").arg(a).arg(b));
+      check(matrix(a, b) == matrix(b, a), "symmetric matrix");
+    }
+  }
+}
+
+// pairs that share less than two months have no correlation
+
+void test_correlation_matrix_no_overlap() {
+  Eigen::MatrixXd data(4, 2);
+  Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> mask(4, 2);
+
+  data << 1.0, 0.0, 2.0, 0.0, 0.0, 3.0, 0.0, 1.0;
+  mask << true, false, true, false, false, true, false, true;
+
+  const Eigen::MatrixXd matrix = correlation_matrix(data, mask);
+
+  check(matrix(0, 1) == 0.0, "pair without shared months");
+}
+
+/*
+  The rolling explained variance has to match a full eigen decomposition of each window. The values have a large
+  offset and the window slides through a long history, the case where sums of raw products lose precision.
+*/
+
+void test_rolling_explained_variance() {
+  const int n_months = 2000;
+  const int n_series = 6;
+  const int window = 24;
+
+  std::mt19937_64 rng(2);
+
+  std::normal_distribution<double> returns(0.0, 1.0);
+
+  Eigen::MatrixXd data(n_months, n_series);
+  Eigen::Array<bool, Eigen::Dynamic, Eigen::Dynamic> mask(n_months, n_series);
+
+  mask.setConstant(true);
+
+  for (int n = 0; n < n_months; n++) {
+    const double market = returns(rng);
+
+    for (int m = 0; m < n_series; m++) {
+      data(n, m) = 1e6 + (m + 1) * market + returns(rng);
+    }
+  }
+
+  const Eigen::MatrixXd rolling = rolling_explained_variance(data, mask, window, 2);
+
+  double max_error = 0.0;
+
+  for (int n = window - 1; n < n_months; n++) {
+    const Eigen::MatrixXd block = data.middleRows(n - window + 1, window);
+    const Eigen::MatrixXd centered = block.rowwise() - block.colwise().mean();
+
+    const Eigen::VectorXd stddev = centered.colwise().norm().transpose();
+    const Eigen::MatrixXd standardized = centered * stddev.cwiseInverse().asDiagonal();
+
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(standardized.transpose() * standardized);
+
+    const Eigen::VectorXd eigenvalues = solver.eigenvalues().reverse();
+
+    for (int k = 0; k < 2; k++) {
+      max_error = std::max(max_error, std::fabs(rolling(n, k) - 100 * eigenvalues(k) / eigenvalues.sum()));
+    }
+  }
+
+  check(max_error < 0.001, "rolling explained variance matches the full decomposition");
+}
+
+}  // namespace
+
+auto main() -> int {
+  test_correlation_matrix_staggered_start();
+  test_correlation_matrix_no_overlap();
+  test_rolling_explained_variance();
+
+  return failures;
+}